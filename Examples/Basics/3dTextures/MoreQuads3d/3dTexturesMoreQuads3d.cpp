@@ -44,7 +44,7 @@ class Textures3dMoreQuads3dApp : public VulkanApplication3D
 
 	void DrawScene(VkCommandBuffer commandBuffer) override
 	{
-		vkCmdBindVertexBuffers(commandBuffer, 0, 1, &vertexBuffer.GetBuffer(), VulkanPlayground::zeroOffset);
+		vertexBuffer.Bind(commandBuffer);
 		pipeline.Bind(commandBuffer, descriptor);
 		vkCmdDraw(commandBuffer, Attribs::NumVertices(quadVertices, Attribs::PosNormTex), (numQuads + 1) * texture.GetNumLayers(), 0, 0);
 	}
@@ -56,7 +56,7 @@ class Textures3dNoise3dApp : public VulkanApplication3D
 
 	void DrawScene(VkCommandBuffer commandBuffer) override
 	{
-		vkCmdBindVertexBuffers(commandBuffer, 0, 1, &vertexBuffer.GetBuffer(), VulkanPlayground::zeroOffset);
+		vertexBuffer.Bind(commandBuffer);
 		pipeline.Bind(commandBuffer, descriptor);
 		vkCmdDraw(commandBuffer, Attribs::NumVertices(quadVertices, Attribs::PosNormTex), 1, 0, 0);
 	}
@@ -45,7 +45,7 @@ public:
 		std::vector<uint8_t> plookup;
 		plookup.resize(256);
 		std::iota(plookup.begin(), plookup.end(), '\0');
-		std::default_random_engine rndEngine(std::random_device{}());
+		std::default_random_engine rndEngine(VulkanPlayground::RandomSeed());
 		std::shuffle(plookup.begin(), plookup.end(), rndEngine);
 
 		for (uint32_t i = 0; i < 256; i++)
@@ -146,6 +146,7 @@ void GenerateNoise(bool fractal, float noiseScale, PixelData* pd)
 	// Generate perlin based noise
 	std::cout << "Generating " << widthSize << " x " << heightSize << " x " << depthSize << " noise texture..." << std::endl;
 
+	PROFILE_ZONE("Generate Noise");
 	auto tStart = std::chrono::high_resolution_clock::now();
 
 	pd->size = (uint64_t)(widthSize * heightSize * depthSize * sizeof(uint8_t));
@@ -49,7 +49,7 @@ class Textures3dSamplerArrayMoreQuadsApp : public VulkanApplication3D
 	{
 		pipeline.PushConstant(commandBuffer, &multiSample);
 
-		vkCmdBindVertexBuffers(commandBuffer, 0, 1, &vertexBuffer.GetBuffer(), VulkanPlayground::zeroOffset);
+		vertexBuffer.Bind(commandBuffer);
 		pipeline.Bind(commandBuffer, descriptor);
 		vkCmdDraw(commandBuffer, Attribs::NumVertices(quadVertices, Attribs::PosNormTex), (numQuads + 1) * texture.GetNumLayers(), 0, 0);
 	}
@@ -9,6 +9,7 @@
 	extern VulkanApplication& Create ## apps ## name ## App(); \
 	auto& apps ## name = Create ## apps ## name ## App(); \
 	if (fontsEnabled) apps ## name.SetTextHelper(new BasicStrings(*this, #apps, #name, IDR_ ## apps ## _ ## name ##)); \
+	appNames[&apps ## name] = #apps "/" #name; \
 	apps ## Apps.push_back(&apps ## name)
 
 AppGroups::AppGroups(bool fontsEnabled)
@@ -1,6 +1,8 @@
 #pragma once
 
 #include <vector>
+#include <map>
+#include <string>
 
 class VulkanApplication;
 class GLFW;
@@ -75,6 +77,19 @@ public:
 			return false;
 	}
 
+	AppList GetAllApps() const
+	{
+		AppList apps;
+		for (auto& group : groups)
+			apps.insert(apps.end(), group.begin(), group.end());
+		return apps;
+	}
+	std::string GetAppName(VulkanApplication* app) const
+	{
+		auto pos = appNames.find(app);
+		return (pos != appNames.end()) ? pos->second : "";
+	}
+
 	uint32_t GetCurrentGroupNum() { return currentGroup + 1; }
 	uint32_t GetNumGroups() { return (uint32_t)groups.size(); }
 	uint32_t GetCurrentSubgroupNum() { return currentSubgroup + 1; }
@@ -90,6 +105,7 @@ protected:
 private:
 	std::vector<AppList> groups;
 	std::vector<uint32_t> groupPosition;
+	std::map<VulkanApplication*, std::string> appNames;	// "Group/Name"
 	uint32_t currentGroup;
 	uint32_t currentSubgroup;
 	bool newScene = false;
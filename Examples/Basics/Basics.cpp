@@ -2,6 +2,7 @@
 #include <VulkanPlayground\WindowSystem.h>
 #include <VulkanPlayground\WinUtil.h>
 #include "VulkanPlayground\BitmapFont.h"
+#include "VulkanPlayground\Benchmark.h"
 #include "Basics.h"
 #include "AppGroups.h"
 #include "resource.h"
@@ -12,12 +13,102 @@ bool CheckKeys(GLFW& window, void* data)
 	return appGroups.CheckKeys(window);
 }
 
-int main()
+// Renders each example for a number of frames without a window, e.g. "Basics --headless 100" (defaults to 60 frames)
+// Given a folder, e.g. "Basics --headless 60 Golden", the last frame of each is checked against <folder>/<Group>_<Name>.png (saved there first time round)
+int RunHeadless(int numFrames, const std::string& goldenFolder)
 {
+	WindowSystem windowSystem;
+	AppGroups appGroups(windowSystem.GetVulkanSystem().fontsEnabled);
+	if (!windowSystem.InitHeadless(1200, 800, "Basic Examples"))
+		return 1;
+
+	windowSystem.SetFrameLimit(numFrames);
+	windowSystem.SetDeterministic();
+	int failures = 0;
+	for (auto app : appGroups.GetAllApps())
+	{
+		std::string name = appGroups.GetAppName(app);
+		std::replace(name.begin(), name.end(), '/', '_');
+		std::string goldenFile = goldenFolder + "/" + name + ".png";
+		if (!goldenFolder.empty())
+		{
+			bool haveGolden = std::ifstream(goldenFile).good();
+			windowSystem.SetFrameCapture(haveGolden ? goldenFolder + "/" + name + ".capture.png" : goldenFile, haveGolden ? goldenFile : "");
+		}
+
+		if (!windowSystem.RunApp(*app))
+			failures++;
+		else if (windowSystem.GetLastRunStats().goldenCompared)
+		{
+			auto& golden = windowSystem.GetLastRunStats().golden;
+			if (golden.Passed(0.001))	// Allow for the odd pixel on an edge
+				std::cout << name << " matches golden image (" << golden.GetSummary() << ")\n";
+			else
+			{
+				WinUtils::OutputError(name + " doesn't match golden image: " + golden.GetSummary());
+				failures++;
+			}
+		}
+	}
+	windowSystem.Close();
+	return failures;
+}
+
+// Times each example headless at a fixed 60Hz timestep, e.g. "Basics --benchmark Report.json 300" (defaults to Benchmark.json and 300 frames after a 30 frame warm-up)
+// Each example's frame times are also written beside the report, e.g. Report_Texture_Shield.csv and .json
+int RunBenchmark(const std::string& reportFile, int numFrames)
+{
+	Benchmark benchmark(1200, 800, 30, numFrames);
+	AppGroups appGroups(false);	// No text, the benchmark disables fonts
+	if (!benchmark.Init("Basic Examples Benchmark"))
+		return 1;
+
+	auto extension = reportFile.find_last_of("./\\");
+	std::string statsFile = (extension != std::string::npos && reportFile[extension] == '.') ? reportFile.substr(0, extension) : reportFile;
+	for (auto app : appGroups.GetAllApps())
+	{
+		std::string name = appGroups.GetAppName(app);
+		std::string fileName = name;
+		std::replace(fileName.begin(), fileName.end(), '/', '_');
+		app->SetFrameStatsFile(statsFile + "_" + fileName);
+		benchmark.Run(name, *app);
+	}
+	benchmark.Close();
+
+	if (!benchmark.WriteReport(reportFile))
+		WinUtils::OutputError("Failed to write " + reportFile);
+	return (int)benchmark.GetNumFailed();
+}
+
+int main(int argc, char* argv[])
+{
+	if (argc > 1 && std::string(argv[1]) == "--headless")
+		return RunHeadless(argc > 2 ? std::stoi(argv[2]) : 60, argc > 3 ? argv[3] : "");
+	if (argc > 1 && std::string(argv[1]) == "--benchmark")
+		return RunBenchmark(argc > 2 ? argv[2] : "Benchmark.json", argc > 3 ? std::stoi(argv[3]) : 300);
+
 	WindowSystem windowSystem;
 	AppGroups appGroups(windowSystem.GetVulkanSystem().fontsEnabled);
 	windowSystem.InitWindow(1200, 800, "Basic Examples", CheckKeys, &appGroups);
 
+	// "--compile" builds the shaders from their GLSL source (cached in bin\ShaderCache) rather than loading the prebuilt .spv files
+	if (std::find(argv + 1, argv + argc, std::string("--compile")) != argv + argc)
+		windowSystem.GetVulkanSystem().EnableRuntimeShaderCompile(true);
+
+	// "--record Input.txt" saves the input so "--replay Input.txt" can repeat the run, both at a fixed timestep
+	if (argc > 2 && std::string(argv[1]) == "--record")
+	{
+		windowSystem.SetDeterministic();
+		if (!windowSystem.GetEventData().StartRecording(argv[2]))
+			WinUtils::OutputError("Failed to record to " + std::string(argv[2]));
+	}
+	else if (argc > 2 && std::string(argv[1]) == "--replay")
+	{
+		windowSystem.SetDeterministic();
+		if (!windowSystem.GetEventData().StartReplay(argv[2]))
+			WinUtils::OutputError("Nothing to replay in " + std::string(argv[2]));
+	}
+
 	do
 	{
 		windowSystem.RunApp(appGroups.GetCurrentApp());
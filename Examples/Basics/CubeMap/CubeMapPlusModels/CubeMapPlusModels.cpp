@@ -54,17 +54,12 @@ class CubeMapCubeMapPlusModelsApp : public VulkanApplication3DLight
 
 	void DrawScene(VkCommandBuffer commandBuffer) override
 	{
+		drawList.Clear();
 		if (showModel)
-		{
-			pipelineModel.PushConstant(commandBuffer, &showReflection);
-			pipelineModel.Bind(commandBuffer, descriptorModel.GetDescriptorSet());
-			models[curModel].Draw(commandBuffer);
-		}
+			drawList.AddDrawWithPushConstants(pipelineModel, descriptorModel.GetDescriptorSet(), models[curModel], showReflection);
 		if (showSkybox)
-		{
-			pipelineCube.Bind(commandBuffer, descriptorCube.GetDescriptorSet());
-			cubeModel.Draw(commandBuffer);
-		}
+			drawList.AddDraw(pipelineCube, descriptorCube.GetDescriptorSet(), cubeModel);	// After the model, so only the uncovered parts are shaded
+		drawList.Record(commandBuffer);
 	}
 
 	void ProcessKeyPresses(const EventData& eventData) override
@@ -115,6 +110,7 @@ private:
 	Model cubeModel;	
 	Pipeline pipelineCube;
 	Descriptor descriptorCube;
+	DrawList drawList;
 	UBO<MVP> uniformBufferCube;
 	Buffer vertexBufferCube;
 	
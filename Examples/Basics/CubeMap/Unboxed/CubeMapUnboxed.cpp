@@ -47,7 +47,7 @@ class CubeMapUnboxedApp : public VulkanApplication3D
 
 	void DrawScene(VkCommandBuffer commandBuffer) override
 	{
-		vkCmdBindVertexBuffers(commandBuffer, 0, 1, &vertexBuffer.GetBuffer(), VulkanPlayground::zeroOffset);
+		vertexBuffer.Bind(commandBuffer);
 
 		for (uint32_t buff = 0; buff < TEXTURE_ARRAY_SIZE; buff++)
 		{
@@ -22,14 +22,33 @@ class DescriptorSetsLitCubesApp : public VulkanApplication3DLight
 		descriptor2.AddUniformBuffer(system, 2, lightUBO, "Light Info", VK_SHADER_STAGE_FRAGMENT_BIT);
 		descriptor2.AddTexture(system, 1, texture2, VulkanPlayground::GetModelFile("Basics", "crate02_color_height_rgba.ktx"));
 		CreateSharedDescriptor(system, descriptor2, descriptor1.GetDescriptorSetLayout(), "Drawing2");
+		descriptor1.CreateUpdateTemplate(system, "Drawing1");	// For swapping the textures
+		descriptor2.CreateUpdateTemplate(system, "Drawing2");
+		texturesSwapped = false;
 
 		pipeline.SetupVertexDescription(Attribs::PosNormTex);
 		pipeline.LoadShader(system, "cubelit");
 		CreatePipeline(system, renderPass, pipeline, descriptor1, workingExtent, "Scene");
 	};
 
+	void ProcessKeyPresses(const EventData& eventData) override
+	{
+		if (eventData.KeyPressed('T'))
+			swapTextures = true;
+	}
+
 	void UpdateScene(VulkanSystem& system, float /*frameTime*/) override
 	{
+		if (swapTextures)
+		{	// Rewrite both sets in one call each, the data is laid out in binding order
+			swapTextures = false;
+			texturesSwapped = !texturesSwapped;
+			system.DeviceWaitIdle();	// Sets can't be updated while in use
+			descriptor1.Update(system, GetDescriptorData(mvpUBO, texturesSwapped ? texture2 : texture1));
+			descriptor2.Update(system, GetDescriptorData(uniformBuffer2, texturesSwapped ? texture1 : texture2));
+			RedrawScene();	// Updating the sets invalidates the command buffers using them
+		}
+
 		uniformBuffer2().projection = mvpUBO().projection;
 		uniformBuffer2().view = mvpUBO().view;
 		uniformBuffer2().model = glm::translate(mvpUBO().model, glm::vec3(4.0f, 0.0f, 0.0f));	// Move 2nd cube away from first one
@@ -45,12 +64,25 @@ class DescriptorSetsLitCubesApp : public VulkanApplication3DLight
 		model.Draw(commandBuffer);
 	}
 
+	struct DescriptorData
+	{
+		VkDescriptorBufferInfo mvp;	// Binding 0
+		VkDescriptorBufferInfo light;	// Binding 2
+		VkDescriptorImageInfo texture;	// Binding 1
+	};
+	DescriptorData GetDescriptorData(UBO<MVP>& mvp, const Texture& texture)
+	{
+		return { { mvp.GetBuffer().GetBuffer(), 0, mvp.GetBuffer().GetBufferSize() }, { lightUBO.GetBuffer().GetBuffer(), 0, lightUBO.GetBuffer().GetBufferSize() },
+			{ texture.GetSampler(), texture.GetImageView(), VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL } };
+	}
+
 private:
 	Pipeline pipeline;
 	Descriptor descriptor1, descriptor2;
 	Texture texture1, texture2;
 	UBO<MVP> uniformBuffer2;
 	Model model;
+	bool swapTextures = false, texturesSwapped = false;
 };
 
 DECLARE_APP(DescriptorSetsLitCubes)
@@ -13,11 +13,22 @@ class DescriptorSetsTwoCubesApp : public VulkanApplication3D
 		model.LoadToGpu(system, VulkanPlayground::GetModelFile("Basics", "cube.obj"), Attribs::PosTex);
 		descriptor1.AddUniformBuffer(system, 0, mvpUBO, "MVP1");
 		descriptor1.AddTexture(system, 1, texture1, VulkanPlayground::GetModelFile("Basics", "crate01_color_height_rgba.ktx"));
-		CreateBaseDescriptor(system, descriptor1, "Drawing1", 2);
-
 		descriptor2.AddUniformBuffer(system, 0, uniformBuffer2, "MVP2");
 		descriptor2.AddTexture(system, 1, texture2, VulkanPlayground::GetModelFile("Basics", "crate02_color_height_rgba.ktx"));
-		CreateSharedDescriptor(system, descriptor2, descriptor1.GetDescriptorSetLayout(), "Drawing2");
+
+		usePushDescriptors = system.PushDescriptorsSupported();
+		if (usePushDescriptors)
+		{	// No sets are allocated, each cube's buffer and texture are written into the command buffer before its draw
+			CreatePushDescriptor(system, descriptor1, "Drawing1");
+			CreatePushDescriptor(system, descriptor2, "Drawing2");	// Same layout, just looks after the second cube's resources
+			pushData[0] = GetPushData(mvpUBO, texture1);
+			pushData[1] = GetPushData(uniformBuffer2, texture2);
+		}
+		else
+		{
+			CreateBaseDescriptor(system, descriptor1, "Drawing1", 2);
+			CreateSharedDescriptor(system, descriptor2, descriptor1.GetDescriptorSetLayout(), "Drawing2");
+		}
 
 		pipeline.SetupVertexDescription(Attribs::PosTex);
 		pipeline.LoadShader(system, "cube");
@@ -34,6 +45,17 @@ class DescriptorSetsTwoCubesApp : public VulkanApplication3D
 
 	void DrawScene(VkCommandBuffer commandBuffer) override
 	{
+		if (usePushDescriptors)
+		{
+			pipeline.Bind(commandBuffer);
+			for (auto& data : pushData)
+			{
+				pipeline.PushDescriptor(commandBuffer, descriptor1, data);
+				model.Draw(commandBuffer);
+			}
+			return;
+		}
+
 		pipeline.Bind(commandBuffer, descriptor1);
 		model.Draw(commandBuffer);
 
@@ -41,12 +63,24 @@ class DescriptorSetsTwoCubesApp : public VulkanApplication3D
 		model.Draw(commandBuffer);
 	}
 
+	struct PushData	// In binding order
+	{
+		VkDescriptorBufferInfo mvp;
+		VkDescriptorImageInfo texture;
+	};
+	static PushData GetPushData(UBO<MVP>& mvp, const Texture& texture)
+	{
+		return { { mvp.GetBuffer().GetBuffer(), 0, mvp.GetBuffer().GetBufferSize() }, { texture.GetSampler(), texture.GetImageView(), VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL } };
+	}
+
 private:
 	Pipeline pipeline;
 	Descriptor descriptor1, descriptor2;
 	Texture texture1, texture2;
 	UBO<MVP> uniformBuffer2;
 	Model model;
+	bool usePushDescriptors = false;
+	PushData pushData[2] = {};
 };
 
 DECLARE_APP(DescriptorSetsTwoCubes)
@@ -2,6 +2,12 @@
 
 class DynamicUniformBufferCubeOfCubesApp : public VulkanApplication3D
 {
+public:
+	DynamicUniformBufferCubeOfCubesApp()
+	{
+		TidyObjectOnExit(indirectDraw);
+	}
+
 	struct UBO_vp
 	{
 		glm::mat4 view;
@@ -12,6 +18,12 @@ class DynamicUniformBufferCubeOfCubesApp : public VulkanApplication3D
 		glm::mat4 model;
 	};
 
+	void GetRequiredDeviceFeatures(const VkPhysicalDeviceFeatures& deviceFeatures, VkPhysicalDeviceFeatures* requiredFeatures) override
+	{
+		if (deviceFeatures.drawIndirectFirstInstance)
+			VulkanPlayground::EnableIndirectDrawing(deviceFeatures, requiredFeatures);
+	}
+
 	void ResetScene() override
 	{
 		cubeDimension = 2;
@@ -21,7 +33,8 @@ class DynamicUniformBufferCubeOfCubesApp : public VulkanApplication3D
 	{
 		CalcPositionMatrixMoveBack(cubeDimension * 2.0f, model.GetModelSize());
 		worldPos.Reset(glm::vec3((cubeDimension - 1) * 1.25f), 0, 0);
-		RecreateObjects();
+		if (!useIndirect)
+			RecreateObjects();	// The dynamic buffer is sized for the number of cubes, the indirect draw just draws however many are added
 	}
 
 	void SetupObjects(VulkanSystem& system, RenderPass& renderPass, VkExtent2D workingExtent) override
@@ -30,18 +43,39 @@ class DynamicUniformBufferCubeOfCubesApp : public VulkanApplication3D
 		if (cubeDimension == 0)
 			return;
 
+		useIndirect = useIndirect && system.GetEnabledDeviceFeatures().drawIndirectFirstInstance;
 		descriptor.AddUniformBuffer(system, 0, uniformBuffer, "VP");
-		descriptor.AddDynamicUniformBuffer(system, 1, dynamicUniformBuffer, cubeDimension * cubeDimension * cubeDimension, "Model");
+		if (useIndirect)
+		{
+			if (!indirectDraw.Created())
+			{
+				cubeMesh = indirectDraw.AddMesh(model);
+				uint32_t maxCubes = maxCubeDimension * maxCubeDimension * maxCubeDimension;
+				indirectDraw.Create(system, maxCubes, maxCubes, sizeof(glm::mat4), "Cubes");
+			}
+			descriptor.AddStorageBuffer(1, indirectDraw.GetInstanceBuffer());
+		}
+		else
+			descriptor.AddDynamicUniformBuffer(system, 1, dynamicUniformBuffer, cubeDimension * cubeDimension * cubeDimension, "Model");
 		descriptor.AddTexture(system, 2, texture, VulkanPlayground::GetModelFile("Basics", "crate01_color_height_rgba.ktx"));
 		CreateDescriptor(system, descriptor, "Drawing");
 
 		pipeline.SetupVertexDescription(Attribs::PosNormTex);
-		pipeline.LoadShader(system, "cubeDynUbo");
+		if (useIndirect)
+			pipeline.LoadShaderDiffNames(system, "cubeIndirect", "cubeDynUbo");
+		else
+			pipeline.LoadShader(system, "cubeDynUbo");
 		CreatePipeline(system, renderPass, pipeline, descriptor, workingExtent, "Scene");
 	};
 
 	void DrawScene(VkCommandBuffer commandBuffer) override
 	{
+		if (useIndirect)
+		{	// Recorded once for any number of cubes
+			pipeline.Bind(commandBuffer, descriptor.GetDescriptorSet());
+			indirectDraw.Record(commandBuffer);
+			return;
+		}
 		for (uint32_t buff = 0; buff < dynamicUniformBuffer.GetNumDynamicBuffers(); buff++)
 		{
 			pipeline.Bind(commandBuffer, descriptor.GetDescriptorSet(), buff * dynamicUniformBuffer.GetBlockSize());
@@ -55,19 +89,33 @@ class DynamicUniformBufferCubeOfCubesApp : public VulkanApplication3D
 		uniformBuffer().view = mvpUBO().view;
 		uniformBuffer.CopyToDevice(system);
 
-		// Dynamic ubo with per-object model matrices indexed by offsets in the command buffer
-		for (uint32_t x = 0; x < cubeDimension; x++)
+		// Dynamic ubo with per-object model matrices indexed by offsets in the command buffer, or a draw per visible cube in the indirect buffer
+		uint32_t numCubes = cubeDimension * cubeDimension * cubeDimension;
+		if (useIndirect)
 		{
-			for (uint32_t y = 0; y < cubeDimension; y++)
+			if (culler.GetNumObjects() != numCubes)
 			{
-				for (uint32_t z = 0; z < cubeDimension; z++)
-				{
-					uint32_t index = (x * cubeDimension * cubeDimension) + (y * cubeDimension) + z;
-					dynamicUniformBuffer(index).model = glm::translate(mvpUBO().model, glm::vec3(x * 2.5, y * 2.5, z * 2.5));
-				}
+				culler.Clear();
+				for (uint32_t cube = 0; cube < numCubes; cube++)
+					culler.AddBox(model.GetMinExtent() + CubeOffset(cube), model.GetMaxExtent() + CubeOffset(cube));
 			}
+			indirectDraw.Begin();
+			for (auto cube : culler.Cull(mvpUBO()))	// The boxes are in the same space as the offsets
+				indirectDraw.AddInstance(cubeMesh, glm::translate(mvpUBO().model, CubeOffset(cube)));
+			indirectDraw.End();
+		}
+		else
+		{
+			for (uint32_t cube = 0; cube < numCubes; cube++)
+				dynamicUniformBuffer(cube).model = glm::translate(mvpUBO().model, CubeOffset(cube));
+			dynamicUniformBuffer.CopyToDevice(system);
 		}
-		dynamicUniformBuffer.CopyToDevice(system);
+	}
+
+	glm::vec3 CubeOffset(uint32_t cube) const
+	{	// Ordered by x, y then z
+		uint32_t x = cube / (cubeDimension * cubeDimension), y = (cube / cubeDimension) % cubeDimension, z = cube % cubeDimension;
+		return glm::vec3(x * 2.5f, y * 2.5f, z * 2.5f);
 	}
 
 	void ProcessKeyPresses(const EventData& eventData) override
@@ -81,11 +129,16 @@ class DynamicUniformBufferCubeOfCubesApp : public VulkanApplication3D
 			}
 			else
 			{
-				if (cubeDimension < 25)
+				if (cubeDimension < maxCubeDimension)
 					cubeDimension++;
 			}
 			UpdatePos();
 		}
+		if (eventData.KeyPressed('I'))
+		{
+			useIndirect = !useIndirect;
+			RecreateObjects();
+		}
 	}
 
 private:
@@ -95,7 +148,12 @@ private:
 	Texture texture;
 	UBO<UBO_vp> uniformBuffer;
 	DynamicUBO<UBO_m> dynamicUniformBuffer;
+	IndirectDraw indirectDraw;
+	FrustumCuller culler;
+	uint32_t cubeMesh = 0;
 	uint32_t cubeDimension = 0;
+	static const uint32_t maxCubeDimension = 25;
+	bool useIndirect = false;
 };
 
 DECLARE_APP(DynamicUniformBufferCubeOfCubes)
@@ -0,0 +1,22 @@
+
+#version 450
+
+layout(binding = 0) uniform UniformBufferObject {
+	mat4 view;
+	mat4 proj;
+} ubo;
+
+layout(std430, binding = 1) readonly buffer InstanceData {
+	mat4 model[];
+} instances;
+
+layout(location = 0) in vec3 inPosition;
+layout(location = 1) in vec3 inNormal;
+layout(location = 2) in vec2 inTexCoord;
+
+layout(location = 1) out vec2 fragTexCoord;
+
+void main() {
+	fragTexCoord = inTexCoord;
+	gl_Position = ubo.proj * ubo.view * instances.model[gl_InstanceIndex] * vec4(inPosition, 1.0);
+}
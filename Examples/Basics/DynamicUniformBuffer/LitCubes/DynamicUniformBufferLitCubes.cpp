@@ -49,7 +49,7 @@ class DynamicUniformBufferLitCubesApp : public VulkanApplication3DLight
 		CreatePipeline(system, renderPass, pipeline, descriptor, workingExtent, "Scene");
 
 		// Set cube position offset and rotate amounts
-		std::default_random_engine rndEngine(std::random_device{}());
+		std::default_random_engine rndEngine(VulkanPlayground::RandomSeed());
 		std::normal_distribution<float> rndDist(-2.0f * MathsContants::pi<float>, 2.0f * MathsContants::pi<float>);
 		uint32_t index = 0;
 		for (uint32_t x = 0; x < cubeDimension; x++)
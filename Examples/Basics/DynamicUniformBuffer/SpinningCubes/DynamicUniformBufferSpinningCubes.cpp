@@ -20,7 +20,7 @@ class DynamicUniformBufferSpinningCubesApp : public VulkanApplication3D
 	{
 		totalTime = 0;
 
-		std::default_random_engine rndEngine(std::random_device{}());
+		std::default_random_engine rndEngine(VulkanPlayground::RandomSeed());
 		std::normal_distribution<float> rndDist(-2.0f * MathsContants::pi<float>, 2.0f * MathsContants::pi<float>);
 		for (uint32_t i = 0; i < cubeDimension * cubeDimension * cubeDimension; i++)
 		{
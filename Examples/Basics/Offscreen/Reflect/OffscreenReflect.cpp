@@ -79,7 +79,7 @@ class OffscreenReflectApp : public VulkanApplication3DLight
 
 		reflectPipeline.PushConstant(commandBuffer, &showBlur);
 		reflectPipeline.Bind(commandBuffer, reflectDescriptor);
-		vkCmdBindVertexBuffers(commandBuffer, 0, 1, &planeBuffer.GetBuffer(), VulkanPlayground::zeroOffset);
+		planeBuffer.Bind(commandBuffer);
 		vkCmdDraw(commandBuffer, Attribs::NumVertices(quadVertices, Attribs::PosTex), 1, 0, 0);
 	}
 
@@ -41,7 +41,7 @@ class OffscreenSceneApp : public VulkanApplication3DLight
 		model.Draw(commandBuffer);
 
 		planePipeline.Bind(commandBuffer, planeDescriptor.GetDescriptorSet());
-		vkCmdBindVertexBuffers(commandBuffer, 0, 1, &planeBuffer.GetBuffer(), VulkanPlayground::zeroOffset);
+		planeBuffer.Bind(commandBuffer);
 		vkCmdDraw(commandBuffer, Attribs::NumVertices(quadVertices, Attribs::PosTex), 1, 0, 0);
 	}
 
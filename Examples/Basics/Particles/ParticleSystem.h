@@ -135,7 +135,7 @@ public:
 		particleInfo.reserve(numParticles);
 		particleData.resize(numParticles);
 
-		rndEngine.seed(std::random_device{}());
+		rndEngine.seed(VulkanPlayground::RandomSeed());
 		std::uniform_real_distribution<float> rndDist(0.0f, 4);
 
 		for (uint32_t i = 0; i < numParticles; i++)
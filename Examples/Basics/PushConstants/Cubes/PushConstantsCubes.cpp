@@ -4,10 +4,17 @@
 
 class PushConstantsCubesApp : public VulkanApplication3DLight
 {
+public:
+	PushConstantsCubesApp()
+	{
+		for (auto& texture : textures)
+			TidyObjectOnExit(texture);	// Bindless ones are kept (and stay registered) while the other objects are recreated
+	}
+
 	struct UBO_mr
 	{
 		glm::vec3 rotation;
-		float pad;
+		uint32_t textureIndex;	// Into the bindless texture table, when supported
 		glm::vec3 offset;
 	};
 
@@ -34,17 +41,31 @@ class PushConstantsCubesApp : public VulkanApplication3DLight
 			return;
 
 		descriptor.AddUniformBuffer(system, 0, mvpUBO, "MVP");
-		descriptor.AddTexture(system, 3, texture, VulkanPlayground::GetModelFile("Basics", "crate01_color_height_rgba.ktx"));
+		useBindless = system.BindlessSupported();
+		if (useBindless)
+		{	// The textures come from the bindless table, each cube picks one with its push constant
+			auto& bindlessTextures = system.GetBindlessTextures(numTextures);
+			for (uint32_t tex = 0; tex < numTextures; tex++)
+			{
+				if (textures[tex].GetImageView() == nullptr)
+					textures[tex].Load(system, VulkanPlayground::GetModelFile("Basics", textureFiles[tex]), VK_FORMAT_R8G8B8A8_UNORM);
+				textureIndices[tex] = textures[tex].GetBindlessIndex(system);
+			}
+			bindlessSet = bindlessTextures.GetDescriptorSet();
+			pipeline.AddDescriptorSetLayout(bindlessTextures.GetDescriptorSetLayout());
+		}
+		else
+			descriptor.AddTexture(system, 3, textures[0], VulkanPlayground::GetModelFile("Basics", textureFiles[0]));
 		descriptor.AddUniformBuffer(system, 4, lightUBO, "Light", VK_SHADER_STAGE_FRAGMENT_BIT);
 		CreateDescriptor(system, descriptor, "Drawing");
 
 		pipeline.SetupVertexDescription(Attribs::PosNormTex);
-		pipeline.LoadShader(system, "cubePCLit");
+		pipeline.LoadShaderDiffNames(system, "cubePCLit", useBindless ? "cubePCLitBindless" : "cubePCLit");
 		pipeline.AddPushConstant(system, sizeof(UBO_mr), VK_SHADER_STAGE_VERTEX_BIT);
 		CreatePipeline(system, renderPass, pipeline, descriptor, workingExtent, "Scene");
 
 		// Set cube position offset and rotate amounts
-		std::default_random_engine rndEngine(std::random_device{}());
+		std::default_random_engine rndEngine(VulkanPlayground::RandomSeed());
 		std::normal_distribution<float> rndDist(-2.0f * MathsContants::pi<float>, 2.0f * MathsContants::pi<float>);
 		uint32_t index = 0;
 		delete[] cubeInfo;
@@ -56,6 +77,7 @@ class PushConstantsCubesApp : public VulkanApplication3DLight
 				for (uint32_t z = 0; z < cubeDimension; z++)
 				{
 					cubeInfo[index].rotation = glm::vec3(rndDist(rndEngine), rndDist(rndEngine), rndDist(rndEngine));
+					cubeInfo[index].textureIndex = useBindless ? textureIndices[index % numTextures] : 0;
 					cubeInfo[index].offset = glm::vec3(x, y, z) * glm::vec3(cubeSize * 1.8f);
 					index++;
 				}
@@ -72,6 +94,8 @@ class PushConstantsCubesApp : public VulkanApplication3DLight
 			pipeline.PushConstant(commandBuffer, &cubePos);
 
 			pipeline.Bind(commandBuffer, descriptor);
+			if (useBindless && buff == 0)
+				pipeline.BindDescriptorSet(commandBuffer, 1, bindlessSet);	// Stays bound, the layouts are the same for every cube
 			model.Draw(commandBuffer, (buff == 0));
 		}
 	}
@@ -112,7 +136,12 @@ private:
 	Pipeline pipeline;
 	Descriptor descriptor;
 	Model model;
-	Texture texture;
+	static constexpr uint32_t numTextures = 2;
+	const char* textureFiles[numTextures] = { "crate01_color_height_rgba.ktx", "crate02_color_height_rgba.ktx" };
+	Texture textures[numTextures];
+	uint32_t textureIndices[numTextures] = {};
+	bool useBindless = false;
+	VkDescriptorSet bindlessSet = nullptr;
 	UBO_mr* cubeInfo = nullptr;
 	float totalTime;
 	uint32_t cubeDimension = 0;
@@ -10,6 +10,7 @@ layout(binding = 0) uniform UniformBufferObject
 
 layout(push_constant) uniform CubePushConsts {
 	vec3 rotation;
+	uint textureIndex;
 	vec3 offset;
 } cubeInfo;
 
@@ -20,10 +21,12 @@ layout(location = 2) in vec2 inTexCoord;
 layout(location = 0) out vec2 fragTexCoord;
 layout(location = 1) out vec3 lightPos;
 layout(location = 2) out vec3 lightNormal;
+layout(location = 3) flat out uint textureIndex;
 
 void main()
 {
 	fragTexCoord = inTexCoord;
+	textureIndex = cubeInfo.textureIndex;
 	// Perform matrix operatoins in the shader...
 	vec3 s = sin(cubeInfo.rotation);
 	vec3 c = cos(cubeInfo.rotation);
@@ -26,11 +26,12 @@ class PushConstantsPushConstantSpotApp : public VulkanApplication3DLight
 		descriptor.AddUniformBuffer(system, 0, mvpUBO, "MVP");
 		descriptor.AddUniformBuffer(system, 2, lightUBO, "Lights", VK_SHADER_STAGE_FRAGMENT_BIT);
 		descriptor.AddUniformBuffer(system, 3, spotUBO, "Spot", VK_SHADER_STAGE_FRAGMENT_BIT);
-		CreateDescriptor(system, descriptor, "Drawing");
 
+		// The layouts come from the shaders, so only the resources are given above
 		pipeline.SetupVertexDescription(Attribs::PosNormCol);
 		pipeline.LoadShaderDiffNames(system, "SampleModel", "PushConstantSpot");
-		pipeline.AddPushConstant(system, sizeof(spotLightLookatPos), VK_SHADER_STAGE_FRAGMENT_BIT);
+		CreateSharedDescriptor(system, descriptor, pipeline.GetReflectedDescriptorSetLayout(system, "Drawing"), "Drawing");
+		pipeline.UseReflectedPushConstants(system);
 		CreatePipeline(system, renderPass, pipeline, descriptor, workingExtent, "Scene");
 	}
 
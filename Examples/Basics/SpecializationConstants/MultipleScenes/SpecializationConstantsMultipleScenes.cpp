@@ -2,6 +2,13 @@
 
 class SpecializationConstantsMultipleScenesApp : public VulkanApplication3DLight
 {
+public:
+	SpecializationConstantsMultipleScenesApp()
+	{
+		DeferPipelineCreation();	// Derived scene pipelines are built once the first is done
+	}
+
+private:
 	void ResetScene() override
 	{
 		UseEyeLightSpace();
@@ -17,7 +17,7 @@ class SpecializationConstantsUberShaderSingleApp : public VulkanApplication3DLig
 
 		// Reset to first
 		specializationData.lightingModel = 1;
-		pipeline1.Recreate();	// Need to recreate the pipeline to use the new specialization constant value
+		pipeline1.SpecializationChanged();	// Switch to the pipeline variant using the new specialization constant value
 
 	}
 
@@ -37,6 +37,7 @@ class SpecializationConstantsUberShaderSingleApp : public VulkanApplication3DLig
 		uberShader.SetSpecializationConstantsFromStruct(VK_SHADER_STAGE_FRAGMENT_BIT, &specializationData, { sizeof(specializationData.lightingModel), sizeof(specializationData.toonDesaturationFactor) });
 		specializationData.toonDesaturationFactor = 4;
 		CreatePipeline(system, renderPass, pipeline1, descriptor, workingExtent, "Scene1");
+		pipeline1.PrewarmVariants(system, VK_SHADER_STAGE_FRAGMENT_BIT, std::vector<SpecializationData>{ { 1, 4 }, { 2, 4 }, { 3, 4 } });
 	}
 
 	void UpdateScene(VulkanSystem& system, float /*frameTime*/) override
@@ -55,7 +56,7 @@ class SpecializationConstantsUberShaderSingleApp : public VulkanApplication3DLig
 			specializationData.lightingModel++;
 			if (specializationData.lightingModel == 4)
 				specializationData.lightingModel = 1;
-			pipeline1.Recreate();	// Need to recreate the pipeline to use the new specialization constant value
+			pipeline1.SpecializationChanged();	// Switch to the pipeline variant using the new specialization constant value
 		}
 	}
 
@@ -43,7 +43,7 @@ class StencilBufferCutOutApp : public VulkanApplication3D
 		model.Draw(commandBuffer);
 
 		quadPipeline.Bind(commandBuffer, quadDescriptor);
-		vkCmdBindVertexBuffers(commandBuffer, 0, 1, &vertexBuffer.GetBuffer(), VulkanPlayground::zeroOffset);
+		vertexBuffer.Bind(commandBuffer);
 		vkCmdDraw(commandBuffer, Attribs::NumVertices(quadVerticesPT, Attribs::PosTex), 1, 0, 0);
 	}
 
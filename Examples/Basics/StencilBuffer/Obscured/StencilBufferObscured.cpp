@@ -58,7 +58,7 @@ class StencilBufferObscuredApp : public VulkanApplication3DSimpleLight
 	void DrawScene(VkCommandBuffer commandBuffer) override
 	{
 		quadPipeline.Bind(commandBuffer, quadDescriptor.GetDescriptorSet());
-		vkCmdBindVertexBuffers(commandBuffer, 0, 1, &vertexBuffer.GetBuffer(), VulkanPlayground::zeroOffset);
+		vertexBuffer.Bind(commandBuffer);
 		vkCmdDraw(commandBuffer, Attribs::NumVertices(quadVerticesPT, Attribs::PosTex), 1, 0, 0);
 
 		if (useStencil)
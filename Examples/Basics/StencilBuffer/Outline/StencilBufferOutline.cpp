@@ -16,6 +16,8 @@ class StencilBufferOutlineApp : public VulkanApplication3D
 
 		descriptor.AddUniformBuffer(system, 0, mvpUBO, "MVP");
 		outlineDescriptor.AddUniformBuffer(system, 0, mvpUBO, "MVP");
+		// Both use the same layout and buffer so can share a set, the cache is dropped when everything's recreated (e.g. on resize)
+		descriptorAllocator.CacheDescriptorSets();
 		CreateDescriptors(system, { &descriptor, &outlineDescriptor }, "Main");
 
 		pipeline.EnableStencilTest(VK_COMPARE_OP_ALWAYS, VK_STENCIL_OP_REPLACE);
@@ -14,6 +14,13 @@ class SubPassesGBufferLitApp : public VulkanApplication3DLight
 		float coneSize;
 	};
 
+public:
+	SubPassesGBufferLitApp()
+	{
+		DeferPipelineCreation();	// Build the three subpass pipelines in parallel
+	}
+
+private:
 	struct SpotUBO
 	{
 		Spotlight spots[NUM_SPOTS];
@@ -33,6 +40,7 @@ class SubPassesGBufferLitApp : public VulkanApplication3DLight
 		spotUBO().showSpot = true;
 		spotUBO().hardSpot = false;
 		spotUBO().spotBrightness = 0.5;
+		rndEngine.seed(VulkanPlayground::RandomSeed());
 		CalculateSpotPositions();
 
 		rotate = true;
@@ -9,7 +9,7 @@ class TextureLoDApp : public VulkanApplication3DLight
 		CalcPositionMatrixMoveBack(1);
 		SetupLighting({ -24, -1, 7 }, 0.5f, 0.5f, 0.75f, 32.0f);	// Set lighting to shine on the model
 		loDBias = 0.0f;
-		pipeline.Recreate();
+		RedrawScene();
 	}
 
 	void SetupObjects(VulkanSystem& system, RenderPass& renderPass, VkExtent2D workingExtent) override
@@ -50,7 +50,7 @@ class TextureLoDApp : public VulkanApplication3DLight
 					loDBias -= 1.0f;
 			}
 			
-			pipeline.Recreate();	// Recreate pipeline (to use new bias value)
+			RedrawScene();	// Bias is a push constant, so just need to record the command buffers again
 		}
 	}
 
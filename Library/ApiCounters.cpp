@@ -0,0 +1,192 @@
+#include "stdafx.h"
+#include "ApiCounters.h"
+
+#include <atomic>
+
+// The real Vulkan functions are called with their names in brackets, which stops the counting macros expanding
+
+ApiCallCounts& ApiCallCounts::operator+=(const ApiCallCounts& other)
+{
+	for (size_t call = 0; call < calls.size(); call++)
+		calls[call] += other.calls[call];
+	return *this;
+}
+
+uint32_t ApiCallCounts::GetDraws() const
+{
+	return (*this)[ApiCall::Draw] + (*this)[ApiCall::DrawIndexed] + (*this)[ApiCall::DrawIndirect] + (*this)[ApiCall::DrawIndexedIndirect];
+}
+
+uint32_t ApiCallCounts::GetBinds() const
+{
+	return (*this)[ApiCall::BindPipeline] + (*this)[ApiCall::BindDescriptorSets] + (*this)[ApiCall::PushDescriptorSet] + (*this)[ApiCall::BindVertexBuffers] + (*this)[ApiCall::BindIndexBuffer];
+}
+
+std::string ApiCallCounts::GetSummary() const
+{
+	std::stringstream summary;
+	for (size_t call = 0; call < calls.size(); call++)
+	{
+		if (calls[call] > 0)
+			summary << GetName((ApiCall)call) << " " << calls[call] << "\n";
+	}
+	return summary.str();
+}
+
+const char* ApiCallCounts::GetName(ApiCall call)
+{
+	static const char* names[] = { "BindPipeline", "BindDescriptorSets", "PushDescriptorSet", "BindVertexBuffers", "BindIndexBuffer", "PushConstants",
+		"Draw", "DrawIndexed", "DrawIndirect", "DrawIndexedIndirect", "Dispatch",
+		"QueueSubmit", "AllocateMemory", "AllocateDescriptorSets", "UpdateDescriptorSets", "RedundantSkipped" };
+	static_assert(std::size(names) == (size_t)ApiCall::NumCalls, "Missing call name");
+	return names[(size_t)call];
+}
+
+#ifdef VULKAN_PLAYGROUND_API_COUNTERS
+namespace ApiCounters
+{
+	namespace
+	{
+		// The command buffer being recorded on this thread, and where its calls are counted
+		thread_local VkCommandBuffer recordingBuffer = nullptr;
+		thread_local ApiCallCounts* recordingCounts = nullptr;
+
+		// Calls that aren't recorded can come from other threads, e.g. when loading
+		std::array<std::atomic<uint32_t>, (size_t)ApiCall::NumCalls> currentFrame{};
+		ApiCallCounts lastFrame;	// Only used on the main thread
+
+		void CountCommand(VkCommandBuffer commandBuffer, ApiCall call)
+		{
+			if (recordingCounts != nullptr && commandBuffer == recordingBuffer)
+				(*recordingCounts)[call]++;
+		}
+
+		void CountCall(ApiCall call)
+		{
+			currentFrame[(size_t)call].fetch_add(1, std::memory_order_relaxed);
+		}
+	}
+
+	void NextFrame()
+	{
+		for (size_t call = 0; call < currentFrame.size(); call++)
+			lastFrame.calls[call] = currentFrame[call].exchange(0, std::memory_order_relaxed);
+	}
+
+	ApiCallCounts GetLastFrame()
+	{
+		return lastFrame;
+	}
+
+	void BeginRecording(VkCommandBuffer commandBuffer, ApiCallCounts& counts)
+	{
+		counts = {};
+		recordingBuffer = commandBuffer;
+		recordingCounts = &counts;
+	}
+
+	void EndRecording()
+	{
+		recordingBuffer = nullptr;
+		recordingCounts = nullptr;
+	}
+
+	void Submitted(const ApiCallCounts& counts)
+	{
+		for (size_t call = 0; call < currentFrame.size(); call++)
+		{
+			if (counts.calls[call] > 0)
+				currentFrame[call].fetch_add(counts.calls[call], std::memory_order_relaxed);
+		}
+	}
+
+	void RecordCommand(VkCommandBuffer commandBuffer, ApiCall call)
+	{
+		CountCommand(commandBuffer, call);
+	}
+
+	void CmdBindPipeline(VkCommandBuffer commandBuffer, VkPipelineBindPoint pipelineBindPoint, VkPipeline pipeline)
+	{
+		CountCommand(commandBuffer, ApiCall::BindPipeline);
+		(vkCmdBindPipeline)(commandBuffer, pipelineBindPoint, pipeline);
+	}
+
+	void CmdBindDescriptorSets(VkCommandBuffer commandBuffer, VkPipelineBindPoint pipelineBindPoint, VkPipelineLayout layout, uint32_t firstSet, uint32_t descriptorSetCount, const VkDescriptorSet* pDescriptorSets, uint32_t dynamicOffsetCount, const uint32_t* pDynamicOffsets)
+	{
+		CountCommand(commandBuffer, ApiCall::BindDescriptorSets);
+		(vkCmdBindDescriptorSets)(commandBuffer, pipelineBindPoint, layout, firstSet, descriptorSetCount, pDescriptorSets, dynamicOffsetCount, pDynamicOffsets);
+	}
+
+	void CmdBindVertexBuffers(VkCommandBuffer commandBuffer, uint32_t firstBinding, uint32_t bindingCount, const VkBuffer* pBuffers, const VkDeviceSize* pOffsets)
+	{
+		CountCommand(commandBuffer, ApiCall::BindVertexBuffers);
+		(vkCmdBindVertexBuffers)(commandBuffer, firstBinding, bindingCount, pBuffers, pOffsets);
+	}
+
+	void CmdBindIndexBuffer(VkCommandBuffer commandBuffer, VkBuffer buffer, VkDeviceSize offset, VkIndexType indexType)
+	{
+		CountCommand(commandBuffer, ApiCall::BindIndexBuffer);
+		(vkCmdBindIndexBuffer)(commandBuffer, buffer, offset, indexType);
+	}
+
+	void CmdPushConstants(VkCommandBuffer commandBuffer, VkPipelineLayout layout, VkShaderStageFlags stageFlags, uint32_t offset, uint32_t size, const void* pValues)
+	{
+		CountCommand(commandBuffer, ApiCall::PushConstants);
+		(vkCmdPushConstants)(commandBuffer, layout, stageFlags, offset, size, pValues);
+	}
+
+	void CmdDraw(VkCommandBuffer commandBuffer, uint32_t vertexCount, uint32_t instanceCount, uint32_t firstVertex, uint32_t firstInstance)
+	{
+		CountCommand(commandBuffer, ApiCall::Draw);
+		(vkCmdDraw)(commandBuffer, vertexCount, instanceCount, firstVertex, firstInstance);
+	}
+
+	void CmdDrawIndexed(VkCommandBuffer commandBuffer, uint32_t indexCount, uint32_t instanceCount, uint32_t firstIndex, int32_t vertexOffset, uint32_t firstInstance)
+	{
+		CountCommand(commandBuffer, ApiCall::DrawIndexed);
+		(vkCmdDrawIndexed)(commandBuffer, indexCount, instanceCount, firstIndex, vertexOffset, firstInstance);
+	}
+
+	void CmdDrawIndirect(VkCommandBuffer commandBuffer, VkBuffer buffer, VkDeviceSize offset, uint32_t drawCount, uint32_t stride)
+	{
+		CountCommand(commandBuffer, ApiCall::DrawIndirect);
+		(vkCmdDrawIndirect)(commandBuffer, buffer, offset, drawCount, stride);
+	}
+
+	void CmdDrawIndexedIndirect(VkCommandBuffer commandBuffer, VkBuffer buffer, VkDeviceSize offset, uint32_t drawCount, uint32_t stride)
+	{
+		CountCommand(commandBuffer, ApiCall::DrawIndexedIndirect);
+		(vkCmdDrawIndexedIndirect)(commandBuffer, buffer, offset, drawCount, stride);
+	}
+
+	void CmdDispatch(VkCommandBuffer commandBuffer, uint32_t groupCountX, uint32_t groupCountY, uint32_t groupCountZ)
+	{
+		CountCommand(commandBuffer, ApiCall::Dispatch);
+		(vkCmdDispatch)(commandBuffer, groupCountX, groupCountY, groupCountZ);
+	}
+
+	VkResult QueueSubmit(VkQueue queue, uint32_t submitCount, const VkSubmitInfo* pSubmits, VkFence fence)
+	{
+		CountCall(ApiCall::QueueSubmit);	// The command buffers' calls are added by their owners, see Submitted
+		return (vkQueueSubmit)(queue, submitCount, pSubmits, fence);
+	}
+
+	VkResult AllocateMemory(VkDevice device, const VkMemoryAllocateInfo* pAllocateInfo, const VkAllocationCallbacks* pAllocator, VkDeviceMemory* pMemory)
+	{
+		CountCall(ApiCall::AllocateMemory);
+		return (vkAllocateMemory)(device, pAllocateInfo, pAllocator, pMemory);
+	}
+
+	VkResult AllocateDescriptorSets(VkDevice device, const VkDescriptorSetAllocateInfo* pAllocateInfo, VkDescriptorSet* pDescriptorSets)
+	{
+		CountCall(ApiCall::AllocateDescriptorSets);
+		return (vkAllocateDescriptorSets)(device, pAllocateInfo, pDescriptorSets);
+	}
+
+	void UpdateDescriptorSets(VkDevice device, uint32_t descriptorWriteCount, const VkWriteDescriptorSet* pDescriptorWrites, uint32_t descriptorCopyCount, const VkCopyDescriptorSet* pDescriptorCopies)
+	{
+		CountCall(ApiCall::UpdateDescriptorSets);
+		(vkUpdateDescriptorSets)(device, descriptorWriteCount, pDescriptorWrites, descriptorCopyCount, pDescriptorCopies);
+	}
+}
+#endif
@@ -6,6 +6,7 @@
 #include "RenderPass.h"
 #include "Pipeline.h"
 #include "GLFW.h"
+#include "CpuProfiler.h"
 #include "EventData.h"
 #include "WinUtil.h"
 #include "Descriptor.h"
@@ -15,7 +16,7 @@
 #include "TextHelper.h"
 
 VulkanApplication::VulkanApplication()
-	: windowWidth(0), windowHeight(0), objectsCreated(false), redrawScene(false), resetScene(true), showFPS(false), vSync(true),
+	: windowWidth(0), windowHeight(0), objectsCreated(false), redrawScene(false), resetScene(true), showFPS(false), showFrameStats(false), vSync(true), deferPipelineCreation(false),
 	  depthBufferFormat(VK_FORMAT_UNDEFINED), fontRenderPass(nullptr), textHelper(nullptr)
 {
 }
@@ -58,6 +59,7 @@ void VulkanApplication::SetupWindowObjects(SwapChain& swapChain, VkSurfaceKHR wi
 	swapChain.CreateFrameBuffers(system, renderPasses, GetDepthFormat(system), "Application");
 
 	AppSetupObjects(system, renderPasses, swapChain.GetWorkingExtent());
+	CreateDeferredPipelines(system);
 
 	RedrawScene();
 	objectsCreated = true;
@@ -85,8 +87,11 @@ void VulkanApplication3D::AppSetupObjects(VulkanSystem& system, RenderPasses& re
 
 void VulkanApplication::CreateCommandBuffers(VulkanSystem& system, RenderPasses& renderPasses)
 {
+	PROFILE_FUNCTION();
 	std::vector<std::function<void(VkCommandBuffer)>> drawCmds;
 
+	CreateDeferredPipelines(system);	// Must all exist before being bound
+
 	std::cout << "Draw\n";
 
 	renderPasses.CreateCmdBuffers(0, system,
@@ -107,11 +112,7 @@ void VulkanApplication::TidyDescriptors(VulkanSystem& system)
 		descriptor->Tidy(system);
 	descriptors.clear();
 
-	for (auto pool : descriptorPools)
-	{
-		vkDestroyDescriptorPool(system.GetDevice(), pool, nullptr);
-	}
-	descriptorPools.clear();
+	descriptorAllocator.Reset(system);	// Keep the pools for the recreated descriptors
 }
 
 void VulkanApplication::TidyPipelines(VulkanSystem& system)
@@ -119,11 +120,13 @@ void VulkanApplication::TidyPipelines(VulkanSystem& system)
 	for (auto pipeline : pipelines)
 		pipeline->Tidy(system);
 	pipelines.clear();
+	deferredPipelines.clear();
 }
 
 void VulkanApplication::Tidy(VulkanSystem& system)
 {
 	TidyDescriptors(system);
+	descriptorAllocator.Tidy(system);
 
 	TidyPipelines(system);
 
@@ -135,15 +138,13 @@ void VulkanApplication::Tidy(VulkanSystem& system)
 	RecreateObjects();
 }
 
-void VulkanApplication::CreateDescriptors(VulkanSystem& system, const std::vector<Descriptor*>& descriptorsInput, const std::string& debugDescriptorName, uint32_t extraDescriptors)
+void VulkanApplication::CreateDescriptors(VulkanSystem& system, const std::vector<Descriptor*>& descriptorsInput, const std::string& debugDescriptorName, uint32_t /*extraDescriptors*/)
 {
-	auto descriptorPool = Descriptor::CreateDescriptorPool(system, descriptorsInput, extraDescriptors, debugDescriptorName);
-	descriptorPools.push_back(descriptorPool);
 	auto inc = system.GetScopedDebugOutputIncrement();
 
 	for (auto descriptorDef : descriptorsInput)
 	{
-		descriptorDef->Create(system, descriptorPool, debugDescriptorName);
+		descriptorDef->Create(system, descriptorAllocator, debugDescriptorName);
 		descriptors.push_back(descriptorDef);
 	}
 }
@@ -160,12 +161,21 @@ void VulkanApplication::CreateBaseDescriptor(VulkanSystem& system, Descriptor& d
 
 void VulkanApplication::CreateSharedDescriptor(const VulkanSystem& system, Descriptor& descriptor, VkDescriptorSetLayout otherDescriptorSetLayout, const std::string& debugName)
 {
-	descriptor.CreateShared(system, descriptorPools.back(), otherDescriptorSetLayout, debugName);
+	descriptor.CreateShared(system, descriptorAllocator, otherDescriptorSetLayout, debugName);
+	descriptors.push_back(&descriptor);
+}
+
+void VulkanApplication::CreatePushDescriptor(VulkanSystem& system, Descriptor& descriptor, const std::string& debugName)
+{
+	descriptor.CreatePushDescriptor(system, debugName);
 	descriptors.push_back(&descriptor);
 }
 
 void VulkanApplication::CreatePipeline(VulkanSystem& system, const RenderPass& renderPass, Pipeline& pipeline, Descriptor& descriptor, const VkExtent2D& viewExtent, const std::string& debugName)
 {
+#if _DEBUG
+	descriptor.CheckBindings(pipeline.GetShader().GetReflection(), debugName);
+#endif
 	return CreatePipeline(system, renderPass, pipeline, viewExtent, debugName, descriptor.GetDescriptorSetLayout());
 }
 
@@ -177,10 +187,25 @@ void VulkanApplication::CreatePipeline(VulkanSystem& system, const RenderPass& r
 		viewport.extent = viewExtent;
 		pipeline.SetViewPort(viewport);
 	}
-	pipeline.Create(system, descriptorLayout, renderPass, debugName);
+	if (deferPipelineCreation)
+	{
+		pipeline.Prepare(system, descriptorLayout, renderPass, debugName);
+		deferredPipelines.push_back(&pipeline);
+	}
+	else
+		pipeline.Create(system, descriptorLayout, renderPass, debugName);
 	pipelines.push_back(&pipeline);
 }
 
+void VulkanApplication::CreateDeferredPipelines(VulkanSystem& system)
+{
+	if (!deferredPipelines.empty())
+	{
+		Pipeline::CreatePipelines(system, deferredPipelines);
+		deferredPipelines.clear();
+	}
+}
+
 void VulkanApplication::SetupRenderPasses(RenderPasses& renderPasses, VulkanSystem& system, VkFormat imageFormat)
 {
 	RenderPass& renderPass = renderPasses.NewRenderPass();
@@ -395,7 +420,10 @@ void VulkanApplication::AppProcessKeyPresses(const EventData& eventData)
 			RecreateObjects();
 		}
 		else
-			showFPS = !showFPS;
+		{	// Cycles off -> fps -> fps + frame stats
+			showFrameStats = showFPS && !showFrameStats;
+			showFPS = !showFPS || showFrameStats;
+		}
 	}
 	if (eventData.KeyPressed('R'))
 	{
@@ -416,6 +444,7 @@ void VulkanApplication::ResetPrints(bool clear)
 
 void VulkanApplication::ProcessPrints(VulkanSystem& system, VkExtent2D workingExtent)
 {
+	PROFILE_FUNCTION();
 	std::set<Vulkan2DFont*> changedFonts;
 	bool redraw = false, recreate = false;
 	GetTextHelper()->Process(system, changedFonts, &redraw, &recreate);
@@ -433,8 +462,16 @@ void VulkanApplication::ProcessPrints(VulkanSystem& system, VkExtent2D workingEx
 
 bool VulkanApplication::ObjectsCreated(VulkanSystem &system, RenderPasses& renderPasses)
 {
+	PROFILE_FUNCTION();
 	if (renderPasses.size() > 0)
 	{
+		std::map<std::string, VkShaderModule> changedFiles;
+		if (system.CheckShaderChanges(changedFiles))
+		{
+			for (auto pipeline : pipelines)
+				pipeline->ShaderModulesChanged(system, changedFiles);
+		}
+
 		for (auto pipeline : pipelines)
 		{
 			if (pipeline->CheckRecreate(system, renderPasses.GetScreenRenderPass()))
@@ -462,13 +499,30 @@ TypeSetter& VulkanApplication::PrintString(Vulkan2DFont& font, int x, int y, con
 
 void VulkanApplication::AppUpdateScene(VulkanSystem& system, const FPSTimer& frameTime)
 {
+	PROFILE_FUNCTION();
 	if (showFPS)
 	{
 		auto fpsString = frameTime.LatestFPS();
 		if (vSync)
 			fpsString += " (vSync)";
 		if (GetTextHelper()->ShowingText())
+		{
 			PrintString(10, 30, fpsString);
+			auto gpuString = system.GetGpuProfiler().GetSummary();
+			if (!gpuString.empty())
+				PrintString(10, 50, gpuString);
+			if (showFrameStats)
+			{
+				auto stats = frameTime.GetStats();
+				std::stringstream ss;
+				ss << std::fixed << std::setprecision(1) << "p50 " << stats.p50 << "ms  p95 " << stats.p95 << "ms\np99 " << stats.p99 << "ms  max " << stats.max
+					<< "ms\nstutters " << stats.stutters << "\n" << std::setprecision(0) << frameTime.Histogram();
+#ifdef VULKAN_PLAYGROUND_API_COUNTERS
+				ss << "\n" << ApiCounters::GetLastFrame().GetSummary();	// Only when the calls are counted
+#endif
+				PrintString(windowWidth - 280, 30, ss.str(), glm::vec3(1.0f), 0.8f);
+			}
+		}
 		else
 		{
 			static std::string lastFpsString;
@@ -0,0 +1,83 @@
+#include "stdafx.h"
+#include "Benchmark.h"
+#include "Application.h"
+#include "WinUtil.h"
+#include <iomanip>
+
+Benchmark::Benchmark(int _width, int _height, uint32_t _warmupFrames, uint32_t _measuredFrames, float _timestep)
+	: width(_width), height(_height), warmupFrames(_warmupFrames), measuredFrames(_measuredFrames), timestep(_timestep)
+{}
+
+bool Benchmark::Init(const std::string& name)
+{
+	windowSystem.GetVulkanSystem().fontsEnabled = false;	// Text isn't part of the timings, and its render pass isn't created
+	if (!windowSystem.InitHeadless(width, height, name))
+		return false;
+
+	deviceName = windowSystem.GetVulkanSystem().GetDeviceProperties().deviceName;
+	windowSystem.SetWarmupFrames(warmupFrames);
+	windowSystem.SetFrameLimit(measuredFrames);
+	windowSystem.SetDeterministic(1, timestep);
+	return true;
+}
+
+bool Benchmark::Run(const std::string& sceneName, VulkanApplication& app)
+{
+	WinUtils::OutputYellow("Benchmarking " + sceneName);
+	bool succeeded = windowSystem.RunApp(app);
+	results.push_back(Result{ sceneName, succeeded, windowSystem.GetLastRunStats() });
+	return succeeded;
+}
+
+void Benchmark::Close()
+{
+	windowSystem.Close();
+}
+
+size_t Benchmark::GetNumFailed() const
+{
+	return std::count_if(results.begin(), results.end(), [](const Result& result) { return !result.succeeded; });
+}
+
+bool Benchmark::WriteReport(const std::string& filename) const
+{
+	std::ofstream file(filename);
+	if (!file)
+		return false;
+
+	file << std::fixed << std::setprecision(3);
+	file << "{\n  \"device\": \"" << deviceName << "\",\n  \"width\": " << width << ",\n  \"height\": " << height
+		<< ",\n  \"warmupFrames\": " << warmupFrames << ",\n  \"measuredFrames\": " << measuredFrames << ",\n  \"timestep\": " << timestep << ",\n  \"scenes\": [";
+	for (size_t i = 0; i < results.size(); i++)
+	{
+		auto& result = results[i];
+		auto& frames = result.stats.frameStats;
+		file << (i == 0 ? "\n" : ",\n") << "    {\n      \"name\": \"" << result.sceneName << "\",\n      \"succeeded\": " << (result.succeeded ? "true" : "false")
+			<< ",\n      \"setupMs\": " << result.stats.setupMs
+			<< ",\n      \"cpuFrameMs\": { \"frames\": " << frames.numFrames << ", \"average\": " << frames.average << ", \"p50\": " << frames.p50 << ", \"p95\": " << frames.p95
+			<< ", \"p99\": " << frames.p99 << ", \"max\": " << frames.max << ", \"stutters\": " << frames.stutters << " }"
+			<< ",\n      \"gpuMs\": {";
+		bool first = true;
+		for (auto& region : result.stats.gpuRegionTimes)
+		{
+			file << (first ? " " : ", ") << "\"" << region.first << "\": " << region.second;
+			first = false;
+		}
+		file << (first ? "}" : " }");
+#ifdef VULKAN_PLAYGROUND_API_COUNTERS
+		file << ",\n      \"draws\": " << result.stats.apiCalls.GetDraws() << ",\n      \"binds\": " << result.stats.apiCalls.GetBinds() << ",\n      \"apiCalls\": {";
+		first = true;
+		for (size_t call = 0; call < (size_t)ApiCall::NumCalls; call++)
+		{
+			file << (first ? " " : ", ") << "\"" << ApiCallCounts::GetName((ApiCall)call) << "\": " << result.stats.apiCalls.calls[call];
+			first = false;
+		}
+		file << " }";
+#else
+		file << ",\n      \"draws\": null,\n      \"binds\": null,\n      \"apiCalls\": null";	// Not counted in this build, rather than reporting zeros
+#endif
+		file << ",\n      \"deviceMemory\": " << result.stats.deviceMemory << ",\n      \"peakDeviceMemory\": " << result.stats.peakDeviceMemory << "\n    }";
+	}
+	file << "\n  ]\n}\n";
+	return file.good();
+}
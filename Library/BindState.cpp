@@ -0,0 +1,137 @@
+#include "stdafx.h"
+#include "BindState.h"
+
+bool BindState::filterRedundantState = true;
+
+namespace
+{
+	thread_local BindState* recording = nullptr;	// The one for the command buffer being recorded on this thread
+}
+
+void BindState::Begin(VkCommandBuffer _commandBuffer)
+{
+	*this = BindState();
+	commandBuffer = _commandBuffer;
+	recording = this;
+}
+
+void BindState::End()
+{
+	if (recording == this)
+		recording = nullptr;
+	commandBuffer = nullptr;
+}
+
+BindState* BindState::Get(VkCommandBuffer commandBuffer)
+{
+	return (filterRedundantState && recording != nullptr && recording->commandBuffer == commandBuffer) ? recording : nullptr;
+}
+
+void BindState::CmdBindPipeline(VkCommandBuffer commandBuffer, VkPipelineBindPoint pipelineBindPoint, VkPipeline pipeline)
+{
+	auto state = Get(commandBuffer);
+	if (state != nullptr)
+	{
+		auto& bindPoint = state->GetBindPoint(pipelineBindPoint);
+		if (bindPoint.pipeline == pipeline)
+			return ApiCounters::RecordCommand(commandBuffer, ApiCall::RedundantSkipped);
+		bindPoint.pipeline = pipeline;
+		state->pushLayout = nullptr;	// May not be compatible with the new pipeline's layout
+	}
+	vkCmdBindPipeline(commandBuffer, pipelineBindPoint, pipeline);
+}
+
+void BindState::CmdBindDescriptorSets(VkCommandBuffer commandBuffer, VkPipelineBindPoint pipelineBindPoint, VkPipelineLayout layout, uint32_t firstSet, uint32_t descriptorSetCount, const VkDescriptorSet* pDescriptorSets, uint32_t dynamicOffsetCount, const uint32_t* pDynamicOffsets)
+{
+	auto state = Get(commandBuffer);
+	if (state != nullptr)
+	{
+		auto& bindPoint = state->GetBindPoint(pipelineBindPoint);
+		// The dynamic offsets are only kept (and compared) for a single set
+		bool trackable = (firstSet + descriptorSetCount <= maxSets) && (dynamicOffsetCount == 0 || (descriptorSetCount == 1 && dynamicOffsetCount <= maxDynamicOffsets));
+		if (bindPoint.layout == layout && trackable)
+		{
+			bool same = true;
+			for (uint32_t set = 0; same && set < descriptorSetCount; set++)
+			{
+				auto& bound = bindPoint.sets[firstSet + set];
+				same = (bound.set == pDescriptorSets[set] && bound.numDynamicOffsets == dynamicOffsetCount &&
+					std::equal(pDynamicOffsets, pDynamicOffsets + dynamicOffsetCount, bound.dynamicOffsets));
+			}
+			if (same)
+				return ApiCounters::RecordCommand(commandBuffer, ApiCall::RedundantSkipped);
+		}
+		if (bindPoint.layout != layout)
+		{	// Sets bound with a different layout may be disturbed
+			bindPoint.layout = layout;
+			for (auto& bound : bindPoint.sets)
+				bound = BoundSet();
+		}
+		for (uint32_t set = firstSet; set < std::min(firstSet + descriptorSetCount, maxSets); set++)
+		{
+			auto& bound = bindPoint.sets[set];
+			bound = BoundSet();
+			if (trackable)
+			{
+				bound.set = pDescriptorSets[set - firstSet];
+				bound.numDynamicOffsets = dynamicOffsetCount;
+				std::copy(pDynamicOffsets, pDynamicOffsets + dynamicOffsetCount, bound.dynamicOffsets);
+			}
+		}
+	}
+	vkCmdBindDescriptorSets(commandBuffer, pipelineBindPoint, layout, firstSet, descriptorSetCount, pDescriptorSets, dynamicOffsetCount, pDynamicOffsets);
+}
+
+void BindState::CmdBindVertexBuffers(VkCommandBuffer commandBuffer, uint32_t firstBinding, uint32_t bindingCount, const VkBuffer* pBuffers, const VkDeviceSize* pOffsets)
+{
+	auto state = Get(commandBuffer);
+	if (state != nullptr)
+	{
+		bool same = (firstBinding + bindingCount <= maxVertexBindings);
+		for (uint32_t i = 0; same && i < bindingCount; i++)
+			same = (state->vertexBindings[firstBinding + i].buffer == pBuffers[i] && state->vertexBindings[firstBinding + i].offset == pOffsets[i]);
+		if (same)
+			return ApiCounters::RecordCommand(commandBuffer, ApiCall::RedundantSkipped);
+		for (uint32_t i = 0; i < bindingCount && firstBinding + i < maxVertexBindings; i++)
+			state->vertexBindings[firstBinding + i] = { pBuffers[i], pOffsets[i] };
+	}
+	vkCmdBindVertexBuffers(commandBuffer, firstBinding, bindingCount, pBuffers, pOffsets);
+}
+
+void BindState::CmdBindIndexBuffer(VkCommandBuffer commandBuffer, VkBuffer buffer, VkDeviceSize offset, VkIndexType indexType)
+{
+	auto state = Get(commandBuffer);
+	if (state != nullptr)
+	{
+		if (state->indexBuffer == buffer && state->indexOffset == offset && state->indexType == indexType)
+			return ApiCounters::RecordCommand(commandBuffer, ApiCall::RedundantSkipped);
+		state->indexBuffer = buffer;
+		state->indexOffset = offset;
+		state->indexType = indexType;
+	}
+	vkCmdBindIndexBuffer(commandBuffer, buffer, offset, indexType);
+}
+
+void BindState::CmdPushConstants(VkCommandBuffer commandBuffer, VkPipelineLayout layout, VkShaderStageFlags stageFlags, uint32_t offset, uint32_t size, const void* pValues)
+{
+	auto state = Get(commandBuffer);
+	if (state != nullptr)
+	{	// Only the last push is kept, which is all the bind helpers use
+		if (state->pushLayout == layout && state->pushStages == stageFlags && state->pushOffset == offset && state->pushSize == size && memcmp(state->pushData, pValues, size) == 0)
+			return ApiCounters::RecordCommand(commandBuffer, ApiCall::RedundantSkipped);
+		state->pushLayout = (size <= maxPushConstantSize) ? layout : nullptr;
+		state->pushStages = stageFlags;
+		state->pushOffset = offset;
+		state->pushSize = size;
+		if (state->pushLayout != nullptr)
+			memcpy(state->pushData, pValues, size);
+	}
+	vkCmdPushConstants(commandBuffer, layout, stageFlags, offset, size, pValues);
+}
+
+void BindState::PushedDescriptorSet(VkCommandBuffer commandBuffer, VkPipelineBindPoint pipelineBindPoint, uint32_t set)
+{
+	auto state = Get(commandBuffer);
+	if (state != nullptr && set < maxSets)
+		state->GetBindPoint(pipelineBindPoint).sets[set] = BoundSet();
+}
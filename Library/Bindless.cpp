@@ -0,0 +1,100 @@
+#include "stdafx.h"
+#include "Bindless.h"
+#include "Image.h"
+#include "System.h"
+
+void BindlessTextures::Create(VulkanSystem& system, uint32_t maxTextures, const std::string& debugName)
+{
+	if (!system.BindlessSupported())
+		throw std::runtime_error("Bindless textures need descriptor indexing support");
+
+	VkPhysicalDeviceDescriptorIndexingPropertiesEXT indexingProperties{ VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_DESCRIPTOR_INDEXING_PROPERTIES_EXT };
+	VkPhysicalDeviceProperties2 properties{ VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_PROPERTIES_2 };
+	properties.pNext = &indexingProperties;
+	vkGetPhysicalDeviceProperties2(system.GetPhysicalDevice(), &properties);
+	capacity = std::min({ std::max(maxTextures, minTextures), indexingProperties.maxDescriptorSetUpdateAfterBindSampledImages, indexingProperties.maxDescriptorSetUpdateAfterBindSamplers,
+		indexingProperties.maxPerStageDescriptorUpdateAfterBindSampledImages, indexingProperties.maxPerStageDescriptorUpdateAfterBindSamplers });
+
+	VkDescriptorSetLayoutBinding binding{};
+	binding.binding = 0;
+	binding.descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+	binding.descriptorCount = capacity;
+	binding.stageFlags = VK_SHADER_STAGE_ALL_GRAPHICS;
+
+	// Can be updated while in use and doesn't need every entry to be valid
+	VkDescriptorBindingFlagsEXT bindingFlags = VK_DESCRIPTOR_BINDING_PARTIALLY_BOUND_BIT_EXT | VK_DESCRIPTOR_BINDING_UPDATE_AFTER_BIND_BIT_EXT;
+	VkDescriptorSetLayoutBindingFlagsCreateInfoEXT bindingFlagsInfo{ VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_BINDING_FLAGS_CREATE_INFO_EXT };
+	bindingFlagsInfo.bindingCount = 1;
+	bindingFlagsInfo.pBindingFlags = &bindingFlags;
+
+	VkDescriptorSetLayoutCreateInfo descriptorSetLayoutInfo{ VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO };
+	descriptorSetLayoutInfo.pNext = &bindingFlagsInfo;
+	descriptorSetLayoutInfo.flags = VK_DESCRIPTOR_SET_LAYOUT_CREATE_UPDATE_AFTER_BIND_POOL_BIT_EXT;
+	descriptorSetLayoutInfo.bindingCount = 1;
+	descriptorSetLayoutInfo.pBindings = &binding;
+	CHECK_VULKAN_THROW(vkCreateDescriptorSetLayout(system.GetDevice(), &descriptorSetLayoutInfo, nullptr, &descriptorSetLayout), "Failed to create bindless descriptor set layout");
+	system.DebugNameObject(descriptorSetLayout, VK_OBJECT_TYPE_DESCRIPTOR_SET_LAYOUT, "Descriptor Set Layout", debugName);
+
+	VkDescriptorPoolSize poolSize{ VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, capacity };
+	VkDescriptorPoolCreateInfo descriptorPoolInfo{ VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO };
+	descriptorPoolInfo.flags = VK_DESCRIPTOR_POOL_CREATE_UPDATE_AFTER_BIND_BIT_EXT;
+	descriptorPoolInfo.poolSizeCount = 1;
+	descriptorPoolInfo.pPoolSizes = &poolSize;
+	descriptorPoolInfo.maxSets = 1;
+	CHECK_VULKAN_THROW(vkCreateDescriptorPool(system.GetDevice(), &descriptorPoolInfo, nullptr, &descriptorPool), "Failed to create bindless descriptor pool");
+	system.DebugNameObject(descriptorPool, VK_OBJECT_TYPE_DESCRIPTOR_POOL, "Descriptor Pool", debugName);
+
+	VkDescriptorSetAllocateInfo descriptorSetAllocateInfo{ VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO };
+	descriptorSetAllocateInfo.descriptorPool = descriptorPool;
+	descriptorSetAllocateInfo.descriptorSetCount = 1;
+	descriptorSetAllocateInfo.pSetLayouts = &descriptorSetLayout;
+	CHECK_VULKAN_THROW(vkAllocateDescriptorSets(system.GetDevice(), &descriptorSetAllocateInfo, &descriptorSet), "Failed to allocate bindless descriptor set");
+	system.DebugNameObject(descriptorSet, VK_OBJECT_TYPE_DESCRIPTOR_SET, "Descriptor Set", debugName);
+}
+
+uint32_t BindlessTextures::Register(const VulkanSystem& system, const TextureBase& texture)
+{
+	uint32_t index;
+	if (!freeIndices.empty())
+	{
+		index = freeIndices.back();
+		freeIndices.pop_back();
+	}
+	else
+	{
+		if (nextIndex == capacity)
+			throw std::runtime_error("Bindless texture table is full");
+		index = nextIndex++;
+	}
+
+	VkDescriptorImageInfo imageInfo{};
+	imageInfo.sampler = texture.GetSampler();
+	imageInfo.imageView = texture.GetImageView();
+	imageInfo.imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+
+	VkWriteDescriptorSet writeDS{ VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET };
+	writeDS.dstSet = descriptorSet;
+	writeDS.dstBinding = 0;
+	writeDS.dstArrayElement = index;
+	writeDS.descriptorCount = 1;
+	writeDS.descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+	writeDS.pImageInfo = &imageInfo;
+	vkUpdateDescriptorSets(system.GetDevice(), 1, &writeDS, 0, nullptr);
+
+	return index;
+}
+
+void BindlessTextures::Tidy(VulkanSystem& system)
+{
+	if (descriptorPool != nullptr)
+		vkDestroyDescriptorPool(system.GetDevice(), descriptorPool, nullptr);
+	if (descriptorSetLayout != nullptr)
+		vkDestroyDescriptorSetLayout(system.GetDevice(), descriptorSetLayout, nullptr);
+
+	descriptorPool = nullptr;
+	descriptorSetLayout = nullptr;
+	descriptorSet = nullptr;
+	capacity = 0;
+	nextIndex = 0;
+	freeIndices.clear();
+}
@@ -4,13 +4,14 @@
 #include "Common.h"
 #include "Image.h"
 #include "PixelData.h"
+#include "BindState.h"
 
 void Buffer::Bind(VkCommandBuffer commandBuffer)
 {
 	if ((bufferInfo.usage & VK_BUFFER_USAGE_VERTEX_BUFFER_BIT) == VK_BUFFER_USAGE_VERTEX_BUFFER_BIT)
-		vkCmdBindVertexBuffers(commandBuffer, 0, 1, &buffer, VulkanPlayground::zeroOffset);
+		BindState::CmdBindVertexBuffers(commandBuffer, 0, 1, &buffer, VulkanPlayground::zeroOffset);
 	else if ((bufferInfo.usage & VK_BUFFER_USAGE_INDEX_BUFFER_BIT) == VK_BUFFER_USAGE_INDEX_BUFFER_BIT)
-		vkCmdBindIndexBuffer(commandBuffer, buffer, 0, VK_INDEX_TYPE_UINT32);
+		BindState::CmdBindIndexBuffer(commandBuffer, buffer, 0, VK_INDEX_TYPE_UINT32);
 }
 
 void Buffer::CopyData(VkDevice device, const void* data, VkDeviceSize dataSize)
@@ -69,6 +70,8 @@ void Buffer::Create(VulkanSystem& system, VkDeviceSize _size, VkBufferUsageFlags
 	allocateInfo.memoryTypeIndex = system.FindMemoryType(memRequirements.memoryTypeBits, properties);
 
 	CHECK_VULKAN(vkAllocateMemory(system.GetDevice(), &allocateInfo, nullptr, &deviceMemory), "Failed to allocate buffer memory");
+	allocationSize = allocateInfo.allocationSize;
+	system.MemoryAllocated(allocationSize);
 	CHECK_VULKAN(vkBindBufferMemory(system.GetDevice(), buffer, deviceMemory, 0), "Failed to bind buffer");
 	system.DebugNameObject(deviceMemory, VK_OBJECT_TYPE_DEVICE_MEMORY, "BufferMem", debugName);
 
@@ -360,6 +363,7 @@ void BufferBase::DestroyBuffer(VulkanSystem& system)
 	{
 		FreeBufferInternal(system);
 		vkFreeMemory(system.GetDevice(), deviceMemory, nullptr);
+		system.MemoryFreed(allocationSize);
 		created = false;
 	}
 }
@@ -11,6 +11,7 @@
 #include "System.h"
 #include <regex>
 #include <numeric>
+#include <random>
 
 namespace VulkanPlayground
 {
@@ -27,6 +28,7 @@ namespace VulkanPlayground
 	bool nameObjects = false;
 
 	int bufferCount = 2;	// 2 - double buffering, 3 - triple buffering
+	uint32_t randomSeed = 0;
 
 	const VkFormat offscreenColourBufferFormat = VK_FORMAT_R8G8B8A8_UNORM;
 
@@ -379,7 +381,7 @@ namespace VulkanPlayground
 		return selectedPhysicalDevice;
 	}
 
-	VkDevice CreateLogicalDevice(VkPhysicalDevice physicalDevice, QueueIndicies queueIndicies, const Extensions& extensions, const VkPhysicalDeviceFeatures& deviceFeatures)
+	VkDevice CreateLogicalDevice(VkPhysicalDevice physicalDevice, QueueIndicies queueIndicies, const Extensions& extensions, const VkPhysicalDeviceFeatures& deviceFeatures, const void* featuresChain)
 	{
 		std::vector<VkDeviceQueueCreateInfo> queueCreateInfos;
 		std::set<uint32_t> uniqueQueueFamiles = { queueIndicies.graphicsFamily, queueIndicies.presentFamily, queueIndicies.transferFamily };
@@ -397,6 +399,7 @@ namespace VulkanPlayground
 		deviceInfo.pQueueCreateInfos = queueCreateInfos.data();
 		deviceInfo.queueCreateInfoCount = (uint32_t)queueCreateInfos.size();
 		deviceInfo.pEnabledFeatures = &deviceFeatures;
+		deviceInfo.pNext = featuresChain;	// Extension features
 
 		extensions.AddDeviceExtensions(deviceInfo);
 
@@ -408,18 +411,38 @@ namespace VulkanPlayground
 	VkShaderModule LoadShaderModule(const VulkanSystem& system, const std::string& filename)
 	{
 		std::cout << "Loading shader file: " << filename << "\n";
-		auto shaderCode = ReadFile(filename);
+		return CreateShaderModule(system, ReadFile(filename), WinUtils::GetJustFileName(filename));
+	}
 
+	VkShaderModule CreateShaderModule(const VulkanSystem& system, const std::vector<char>& shaderCode, const std::string& debugName)
+	{
 		VkShaderModuleCreateInfo shaderModuleInfo{ VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO };
 		shaderModuleInfo.codeSize = shaderCode.size();
 		shaderModuleInfo.pCode = (const uint32_t*)shaderCode.data();
 
 		VkShaderModule shaderModule;
 		CHECK_VULKAN(vkCreateShaderModule(system.GetDevice(), &shaderModuleInfo, nullptr, &shaderModule), "Failed to create shader module!");
-		system.DebugNameObject(shaderModule, VK_OBJECT_TYPE_SHADER_MODULE, "ShaderModule", WinUtils::GetJustFileName(filename));
+		system.DebugNameObject(shaderModule, VK_OBJECT_TYPE_SHADER_MODULE, "ShaderModule", debugName);
 		return shaderModule;
 	}
 
+	uint32_t RandomSeed()
+	{
+		return (randomSeed != 0) ? randomSeed : std::random_device{}();
+	}
+
+	uint64_t HashData(const void* data, size_t size)
+	{
+		uint64_t hash = 14695981039346656037ull;
+		auto bytes = (const uint8_t*)data;
+		for (size_t byte = 0; byte < size; byte++)
+		{
+			hash ^= bytes[byte];
+			hash *= 1099511628211ull;
+		}
+		return hash;
+	}
+
 	VkImageView CreateImageView(const VulkanSystem& system, VkImage image, uint32_t mipLevels, VkFormat format, VkImageAspectFlags aspectFlags, const std::string& debugName, VkImageViewType viewType, uint32_t numImages)
 	{
 		VkImageViewCreateInfo ImageViewInfo{ VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO };
@@ -511,6 +534,14 @@ namespace VulkanPlayground
 
 		requiredFeatures->wideLines = VK_TRUE;
 	}
+	void EnableIndirectDrawing(const VkPhysicalDeviceFeatures& deviceFeatures, VkPhysicalDeviceFeatures* requiredFeatures)
+	{
+		if (deviceFeatures.drawIndirectFirstInstance == VK_FALSE)
+			throw std::runtime_error("Indirect draws with a first instance not supported");
+
+		requiredFeatures->drawIndirectFirstInstance = VK_TRUE;
+		requiredFeatures->multiDrawIndirect = deviceFeatures.multiDrawIndirect;	// Otherwise one indirect draw per command
+	}
 }
 
 UnicodeString::UnicodeString(const std::string& utf8String)
@@ -0,0 +1,154 @@
+#include "stdafx.h"
+#include "CpuProfiler.h"
+
+#include <iomanip>
+#include <mutex>
+#include <thread>
+
+namespace CpuProfiler
+{
+	std::atomic<bool> capturing(false);
+
+	namespace
+	{
+		struct Event
+		{
+			const char* name;
+			int64_t start, end;
+		};
+
+		// Only written by its own thread, the count is published after the event so the trace can be written while recording
+		// The events are allocated when the thread first records, so threads that are never captured don't have them
+		struct ThreadBuffer
+		{
+			static const uint32_t maxEvents = 1 << 15;
+			ThreadBuffer(uint32_t id) : threadId(id), capture(0), count(0), released(false)
+			{}
+
+			uint32_t threadId;
+			std::string name;	// Under buffersMutex
+			std::atomic<uint32_t> capture, count;
+			std::unique_ptr<Event[]> events;
+			bool released;	// The thread has finished, under buffersMutex
+		};
+
+		// Released threads' buffers are kept until the next capture, they may be needed when the trace is written
+		std::mutex buffersMutex;
+		std::vector<std::unique_ptr<ThreadBuffer>> buffers;
+		uint32_t nextThreadId = 0;
+		std::atomic<uint32_t> currentCapture(0);
+		const auto epoch = std::chrono::steady_clock::now();
+		thread_local ThreadBuffer* threadBuffer = nullptr;
+
+		ThreadBuffer& GetThreadBuffer()
+		{
+			if (threadBuffer == nullptr)
+			{
+				std::lock_guard<std::mutex> lock(buffersMutex);	// Once per thread
+				buffers.push_back(std::make_unique<ThreadBuffer>(nextThreadId++));
+				threadBuffer = buffers.back().get();
+			}
+			return *threadBuffer;
+		}
+
+		std::string EscapeJson(const std::string& text)
+		{
+			std::string escaped;
+			for (char c : text)
+			{
+				if (c == '"' || c == '\\')
+					escaped += '\\';
+				escaped += c;
+			}
+			return escaped;
+		}
+	}
+
+	void StartCapture()
+	{
+		{
+			std::lock_guard<std::mutex> lock(buffersMutex);
+			buffers.erase(std::remove_if(buffers.begin(), buffers.end(), [](const std::unique_ptr<ThreadBuffer>& buffer) { return buffer->released; }), buffers.end());
+		}
+		currentCapture++;	// Each thread clears its own buffer when it next records
+		capturing = true;
+	}
+
+	void StopCapture()
+	{
+		capturing = false;
+	}
+
+	void SetThreadName(const std::string& name)
+	{
+		auto& buffer = GetThreadBuffer();
+		std::lock_guard<std::mutex> lock(buffersMutex);	// The trace may be being written
+		buffer.name = name;
+	}
+
+	void ReleaseThread()
+	{
+		if (threadBuffer == nullptr)
+			return;
+		std::lock_guard<std::mutex> lock(buffersMutex);
+		if (threadBuffer->count.load(std::memory_order_relaxed) == 0 || threadBuffer->capture.load(std::memory_order_relaxed) != currentCapture.load())
+			buffers.erase(std::find_if(buffers.begin(), buffers.end(), [](const std::unique_ptr<ThreadBuffer>& buffer) { return buffer.get() == threadBuffer; }));
+		else
+			threadBuffer->released = true;	// Part of the current capture
+		threadBuffer = nullptr;	// Pooled threads get a new buffer for their next task
+	}
+
+	int64_t Now()
+	{
+		return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - epoch).count();
+	}
+
+	void Record(const char* name, int64_t start, int64_t end)
+	{
+		auto& buffer = GetThreadBuffer();
+		uint32_t capture = currentCapture.load(std::memory_order_relaxed);
+		if (buffer.capture.load(std::memory_order_relaxed) != capture)
+		{
+			buffer.count.store(0, std::memory_order_relaxed);
+			buffer.capture.store(capture, std::memory_order_release);
+		}
+
+		uint32_t count = buffer.count.load(std::memory_order_relaxed);
+		if (count >= ThreadBuffer::maxEvents)
+			return;	// Full, the rest of the capture is dropped for this thread
+		if (!buffer.events)
+			buffer.events.reset(new Event[ThreadBuffer::maxEvents]);	// Only read once the count says there are events
+		buffer.events[count] = Event{ name, start, end };
+		buffer.count.store(count + 1, std::memory_order_release);
+	}
+
+	bool WriteChromeTrace(const std::string& filename)
+	{
+		std::ofstream file(filename);
+		if (!file)
+			return false;
+
+		uint32_t capture = currentCapture.load();
+		bool first = true;
+		auto separator = [&first]() { auto sep = first ? "\n" : ",\n"; first = false; return sep; };
+
+		file << "{\"traceEvents\":[" << std::fixed << std::setprecision(3);
+		std::lock_guard<std::mutex> lock(buffersMutex);
+		for (auto& buffer : buffers)
+		{
+			if (buffer->capture.load(std::memory_order_acquire) != capture)
+				continue;	// Nothing recorded by this thread
+			uint32_t count = buffer->count.load(std::memory_order_acquire);
+			if (!buffer->name.empty())
+				file << separator() << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":0,\"tid\":" << buffer->threadId << ",\"args\":{\"name\":\"" << EscapeJson(buffer->name) << "\"}}";
+			for (uint32_t i = 0; i < count; i++)
+			{
+				auto& event = buffer->events[i];
+				file << separator() << "{\"name\":\"" << EscapeJson(event.name) << "\",\"ph\":\"X\",\"pid\":0,\"tid\":" << buffer->threadId
+					<< ",\"ts\":" << event.start / 1000.0 << ",\"dur\":" << (event.end - event.start) / 1000.0 << "}";
+			}
+		}
+		file << "\n]}\n";
+		return file.good();
+	}
+}
@@ -3,114 +3,145 @@
 #include "Descriptor.h"
 #include "Image.h"
 #include "System.h"
+#include "ShaderReflection.h"
+#include "WinUtil.h"
 
-VkDescriptorPool Descriptor::CreateDescriptorPool(const VulkanSystem& system, const std::vector<Descriptor*>& descriptors, uint32_t extraDescriptors, const std::string& debugName)
+VkDescriptorPool DescriptorAllocator::NextPool(const VulkanSystem& system, const std::vector<VkDescriptorPoolSize>& required, uint32_t requiredSets, const std::string& debugName)
 {
-	std::vector<VkDescriptorPoolSize> poolSizes;
-	uint32_t maxSets = 0;
-	uint32_t uniformBuffers = 0;
-	uint32_t dynamicBuffers = 0;
-	uint32_t combinedTextures = 0;
-	uint32_t separateTextures = 0;
-	uint32_t imageAttachments = 0;
-
-	for (auto descriptorDef : descriptors)
-	{
-		maxSets++;
-		auto descriptor = descriptorDef;
-		uniformBuffers += (uint32_t)descriptor->uniformBuffers.size();
-		if (descriptor->pDynamicUniformBuffer != nullptr)
-			dynamicBuffers++;
-		if (!descriptor->textures.empty())
-		{
-			if (descriptor->separateSampler)
-				separateTextures += (uint32_t)descriptor->textures.size();
-			else
-				combinedTextures += (uint32_t)descriptor->textures.size();
-		}
-		imageAttachments += descriptor->NumAttachmentImageViews();
-	}
+	if (currentPool != nullptr)
+		usedPools.push_back(currentPool);
 
-	if (uniformBuffers > 0)
-	{
-		VkDescriptorPoolSize uniformPool;
-		uniformPool.type = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
-		uniformPool.descriptorCount = uniformBuffers;
-		poolSizes.push_back(uniformPool);
-	}
-	if (dynamicBuffers > 0)
+	if (!freePools.empty())
 	{
-		VkDescriptorPoolSize dynamicUniformPool;
-		dynamicUniformPool.type = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC;
-		dynamicUniformPool.descriptorCount = dynamicBuffers;
-		poolSizes.push_back(dynamicUniformPool);
-	}
-	if (separateTextures > 0)
-	{
-		VkDescriptorPoolSize samplerPool;
-		samplerPool.type = VK_DESCRIPTOR_TYPE_SAMPLER;
-		samplerPool.descriptorCount = 1;
-		poolSizes.push_back(samplerPool);
-
-		VkDescriptorPoolSize texturePool;
-		texturePool.type = VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE;
-		texturePool.descriptorCount = separateTextures;
-		poolSizes.push_back(texturePool);
-	}
-	if (combinedTextures > 0)
-	{
-		VkDescriptorPoolSize texturePool;
-		texturePool.type = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
-		texturePool.descriptorCount = combinedTextures;
-		poolSizes.push_back(texturePool);
-	}
-	if (imageAttachments > 0)
-	{
-		VkDescriptorPoolSize attachmentPool;
-		attachmentPool.type = VK_DESCRIPTOR_TYPE_INPUT_ATTACHMENT;
-		attachmentPool.descriptorCount = imageAttachments;
-		poolSizes.push_back(attachmentPool);
+		currentPool = freePools.back();
+		freePools.pop_back();
+		return currentPool;
 	}
 
+	// Generous number of each type per set, as we don't know what is going to be allocated from it
+	std::map<VkDescriptorType, uint32_t> typeCounts = {
+		{ VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, 2 },
+		{ VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC, 1 },
+		{ VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, 1 },
+		{ VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, 4 },
+		{ VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE, 4 },
+		{ VK_DESCRIPTOR_TYPE_SAMPLER, 1 },
+		{ VK_DESCRIPTOR_TYPE_INPUT_ATTACHMENT, 4 },
+	};
+	for (auto& type : typeCounts)
+		type.second *= setsPerPool;
+	for (auto& size : required)	// Always big enough for the request that needed it, whatever types it uses
+		typeCounts[size.type] = std::max(typeCounts[size.type], size.descriptorCount);
+
+	std::vector<VkDescriptorPoolSize> poolSizes;
+	for (auto& type : typeCounts)
+		poolSizes.push_back({ type.first, type.second });
+
 	VkDescriptorPoolCreateInfo descriptorPoolInfo{ VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO };
 	descriptorPoolInfo.poolSizeCount = (uint32_t)poolSizes.size();
 	descriptorPoolInfo.pPoolSizes = poolSizes.data();
-	descriptorPoolInfo.maxSets = maxSets + extraDescriptors;
+	descriptorPoolInfo.maxSets = std::max(setsPerPool, requiredSets);
+
+	currentPool = nullptr;
+	VkResult result = vkCreateDescriptorPool(system.GetDevice(), &descriptorPoolInfo, nullptr, &currentPool);
+	if (!CHECK_VULKAN(result, "Failed to create descriptor pool"))
+		throw std::runtime_error("Failed to create descriptor pool [" + debugName + "] (" + std::to_string(result) + ")");
+	system.DebugNameObject(currentPool, VK_OBJECT_TYPE_DESCRIPTOR_POOL, "Descriptor Pool", debugName);
 
-	VkDescriptorPool descriptorPool;
-	CHECK_VULKAN(vkCreateDescriptorPool(system.GetDevice(), &descriptorPoolInfo, nullptr, &descriptorPool), "Failed to create descriptor pool");
-	system.DebugNameObject(descriptorPool, VK_OBJECT_TYPE_DESCRIPTOR_POOL, "Descriptor Pool", debugName);
-	return descriptorPool;
+	setsPerPool = std::min(setsPerPool * 2, maxSetsPerPool);	// Grow each time we need a new one
+	return currentPool;
 }
 
-void Descriptor::CreateDescriptorSet(const VulkanSystem& system, VkDescriptorPool descriptorPool, uint32_t numDescriptors, const std::string& debugName)
+void DescriptorAllocator::Allocate(const VulkanSystem& system, VkDescriptorSetLayout layout, const std::vector<VkDescriptorSetLayoutBinding>& bindings, uint32_t numSets, VkDescriptorSet* descriptorSets, const std::string& debugName)
 {
-	std::vector<VkDescriptorSetLayout> layouts(numDescriptors, descriptorSetLayout);
+	std::map<VkDescriptorType, uint32_t> typeCounts;	// What the sets need, in case a pool has to be made for them
+	for (auto& binding : bindings)
+		typeCounts[binding.descriptorType] += binding.descriptorCount * numSets;
+	std::vector<VkDescriptorPoolSize> required;
+	for (auto& type : typeCounts)
+	{
+		if (type.second > 0)
+			required.push_back({ type.first, type.second });
+	}
+
+	std::vector<VkDescriptorSetLayout> layouts(numSets, layout);
 	VkDescriptorSetAllocateInfo descriptorSetAllocateInfo{ VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO };
-	descriptorSetAllocateInfo.descriptorPool = descriptorPool;
-	descriptorSetAllocateInfo.descriptorSetCount = numDescriptors;
+	descriptorSetAllocateInfo.descriptorSetCount = numSets;
 	descriptorSetAllocateInfo.pSetLayouts = layouts.data();
 
+	VkResult result = VK_ERROR_OUT_OF_POOL_MEMORY;
+	if (currentPool != nullptr)
+	{
+		descriptorSetAllocateInfo.descriptorPool = currentPool;
+		result = vkAllocateDescriptorSets(system.GetDevice(), &descriptorSetAllocateInfo, descriptorSets);
+	}
+	while (result == VK_ERROR_OUT_OF_POOL_MEMORY || result == VK_ERROR_FRAGMENTED_POOL)
+	{	// Current pool is full, so move on to another one, the reset ones first as they may be big enough
+		bool newPool = freePools.empty();
+		descriptorSetAllocateInfo.descriptorPool = NextPool(system, required, numSets, debugName);
+		result = vkAllocateDescriptorSets(system.GetDevice(), &descriptorSetAllocateInfo, descriptorSets);
+		if (newPool)
+			break;	// Made for these sets, so no other pool is going to do any better
+	}
+	if (!CHECK_VULKAN(result, "Failed to allocate descriptor set"))
+		throw std::runtime_error("Failed to allocate " + std::to_string(numSets) + " descriptor sets [" + debugName + "] (" + std::to_string(result) + ")");
+}
+
+bool DescriptorAllocator::FindDescriptorSet(const StateKey& key, VkDescriptorSet& descriptorSet) const
+{
+	auto pos = cachedSets.find(key.Get());
+	if (pos == cachedSets.end())
+		return false;
+
+	descriptorSet = pos->second;
+	return true;
+}
+
+void DescriptorAllocator::Reset(const VulkanSystem& system)
+{
+	if (VulkanPlayground::showObjectCreationMessages && !cachedSets.empty())
+		std::cout << "Dropped " << cachedSets.size() << " cached descriptor sets\n";
+	cachedSets.clear();	// Keyed on the resources' handles, which may be reused by whatever is created next
+	if (currentPool != nullptr)
+		usedPools.push_back(currentPool);
+	currentPool = nullptr;
+
+	for (auto pool : usedPools)
+	{
+		vkResetDescriptorPool(system.GetDevice(), pool, 0);
+		freePools.push_back(pool);
+	}
+	usedPools.clear();
+}
+
+void DescriptorAllocator::Tidy(VulkanSystem& system)
+{
+	Reset(system);
+	for (auto pool : freePools)
+		vkDestroyDescriptorPool(system.GetDevice(), pool, nullptr);
+	freePools.clear();
+}
+
+void Descriptor::CreateDescriptorSet(const VulkanSystem& system, DescriptorAllocator& allocator, uint32_t numDescriptors, const std::string& debugName)
+{
 	std::map<uint32_t, size_t> attahcmentImageCounts;
 
 	descriptorSets.resize(numDescriptors);
-	if (!CHECK_VULKAN(vkAllocateDescriptorSets(system.GetDevice(), &descriptorSetAllocateInfo, descriptorSets.data()), "Failed to allocate descriptor set"))
-		return;
+	if (!allocator.CachingDescriptorSets())
+		allocator.Allocate(system, descriptorSetLayout, bindings, numDescriptors, descriptorSets.data(), debugName);
 
-	for (auto descriptor : descriptorSets)
+	for (auto& descriptor : descriptorSets)
 	{
-		system.DebugNameObject(descriptor, VK_OBJECT_TYPE_DESCRIPTOR_SET, "Descriptor Set", debugName);
-
 		std::vector<VkWriteDescriptorSet> descriptorWrites;
 
 		uint32_t uniformBufferCount = 0;
+		uint32_t storageBufferCount = 0;
 		uint32_t attachmentCount = 0;
 		uint32_t textureCount = 0;
 
 		for (auto& binding : bindings)
 		{
 			VkWriteDescriptorSet writeDS{ VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET };
-			writeDS.dstSet = descriptor;
 			writeDS.descriptorCount = 1;
 			writeDS.dstBinding = binding.binding;
 			writeDS.dstArrayElement = 0;
@@ -143,6 +174,19 @@ void Descriptor::CreateDescriptorSet(const VulkanSystem& system, VkDescriptorPoo
 				writeDS.pBufferInfo = bufferInfo;
 				break;
 			}
+			case VK_DESCRIPTOR_TYPE_STORAGE_BUFFER:
+			{
+				if (storageBufferCount == storageBuffers.size())
+					throw std::runtime_error("Descriptor mismatch - no storage buffer set");
+
+				VkDescriptorBufferInfo* bufferInfo = new VkDescriptorBufferInfo();
+				bufferInfo->buffer = storageBuffers[storageBufferCount]->GetBuffer();
+				bufferInfo->range = storageBuffers[storageBufferCount]->GetBufferSize();
+
+				writeDS.pBufferInfo = bufferInfo;
+				storageBufferCount++;
+				break;
+			}
 			case VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER:
 			case VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE:
 			{
@@ -151,7 +195,7 @@ void Descriptor::CreateDescriptorSet(const VulkanSystem& system, VkDescriptorPoo
 
 				uint32_t numTextures = binding.descriptorCount;
 
-				VkDescriptorImageInfo* imageInfo = new VkDescriptorImageInfo[numTextures];
+				VkDescriptorImageInfo* imageInfo = new VkDescriptorImageInfo[numTextures]();
 				for (uint32_t i = 0; i < numTextures; i++, textureCount++)
 				{
 					imageInfo[i].imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
@@ -165,7 +209,7 @@ void Descriptor::CreateDescriptorSet(const VulkanSystem& system, VkDescriptorPoo
 			}
 			case VK_DESCRIPTOR_TYPE_SAMPLER:
 			{
-				VkDescriptorImageInfo* imageInfo = new VkDescriptorImageInfo[1];
+				VkDescriptorImageInfo* imageInfo = new VkDescriptorImageInfo[1]();
 				imageInfo->sampler = textures[0]->GetSampler();	// Only one sampler
 
 				writeDS.pImageInfo = imageInfo;
@@ -173,7 +217,7 @@ void Descriptor::CreateDescriptorSet(const VulkanSystem& system, VkDescriptorPoo
 			}
 			case VK_DESCRIPTOR_TYPE_INPUT_ATTACHMENT:
 			{
-				VkDescriptorImageInfo* imageInfo = new VkDescriptorImageInfo[1];
+				VkDescriptorImageInfo* imageInfo = new VkDescriptorImageInfo[1]();
 				imageInfo->imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
 				const ImageWithViewList& attachments = *attachmentImageViews[(uint32_t)attachmentCount];
 				auto& index = attahcmentImageCounts[(uint32_t)attachmentCount];
@@ -191,7 +235,26 @@ void Descriptor::CreateDescriptorSet(const VulkanSystem& system, VkDescriptorPoo
 			descriptorWrites.push_back(writeDS);
 		}
 
-		vkUpdateDescriptorSets(system.GetDevice(), (uint32_t)descriptorWrites.size(), descriptorWrites.data(), 0, nullptr);
+		bool update = true;
+		if (allocator.CachingDescriptorSets())
+		{	// Share a set that already has exactly the same layout and resources
+			StateKey key = GetDescriptorSetKey(descriptorWrites);
+			update = !allocator.FindDescriptorSet(key, descriptor);
+			if (update)
+			{
+				allocator.Allocate(system, descriptorSetLayout, bindings, 1, &descriptor, debugName);
+				allocator.AddDescriptorSet(key, descriptor);
+			}
+		}
+
+		if (update)
+		{
+			system.DebugNameObject(descriptor, VK_OBJECT_TYPE_DESCRIPTOR_SET, "Descriptor Set", debugName);
+
+			for (auto& writeDS : descriptorWrites)
+				writeDS.dstSet = descriptor;
+			vkUpdateDescriptorSets(system.GetDevice(), (uint32_t)descriptorWrites.size(), descriptorWrites.data(), 0, nullptr);
+		}
 
 		for (auto& writeDS : descriptorWrites)
 		{
@@ -201,29 +264,209 @@ void Descriptor::CreateDescriptorSet(const VulkanSystem& system, VkDescriptorPoo
 	}
 }
 
-void Descriptor::Create(const VulkanSystem& system, VkDescriptorPool descriptorPool, const std::string& debugDescriptorName, const std::string& debugDescriptorLayoutName)
+StateKey Descriptor::GetDescriptorSetKey(const std::vector<VkWriteDescriptorSet>& descriptorWrites) const
 {
-	// Create descriptor set layout
-	VkDescriptorSetLayoutCreateInfo descriptorSetLayoutInfo = { VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO };
-	descriptorSetLayoutInfo.bindingCount = (uint32_t)bindings.size();
-	descriptorSetLayoutInfo.pBindings = bindings.data();
+	StateKey key;
+	key.Add(descriptorSetLayout);
+	for (auto& writeDS : descriptorWrites)
+	{
+		key.Add(writeDS.dstBinding).Add(writeDS.descriptorType).Add(writeDS.descriptorCount);
+		if (writeDS.pBufferInfo != nullptr)
+			key.AddData(writeDS.pBufferInfo, sizeof(VkDescriptorBufferInfo));
+		if (writeDS.pImageInfo != nullptr)
+			key.AddData(writeDS.pImageInfo, sizeof(VkDescriptorImageInfo) * writeDS.descriptorCount);
+	}
+	return key;
+}
 
-	CHECK_VULKAN(vkCreateDescriptorSetLayout(system.GetDevice(), &descriptorSetLayoutInfo, nullptr, &descriptorSetLayout), "Failed to create descriptor set layout");
-	system.DebugNameObject(descriptorSetLayout, VK_OBJECT_TYPE_DESCRIPTOR_SET_LAYOUT, "Descriptor Set Layout", (debugDescriptorLayoutName.empty() ? debugDescriptorName : debugDescriptorLayoutName));
+void Descriptor::Create(VulkanSystem& system, DescriptorAllocator& allocator, const std::string& debugDescriptorName, const std::string& debugDescriptorLayoutName)
+{
+	// Get a descriptor set layout matching the bindings, shared with any other descriptors with the same bindings
+	descriptorSetLayout = system.GetDescriptorSetLayout(bindings, debugDescriptorLayoutName.empty() ? debugDescriptorName : debugDescriptorLayoutName);
 
 	// Create the descriptor set
-	CreateDescriptorSet(system, descriptorPool, 1/*numDescriptors*/, debugDescriptorName);	// Just use single descriptors?
+	CreateDescriptorSet(system, allocator, 1/*numDescriptors*/, debugDescriptorName);	// Just use single descriptors?
 }
 
-void Descriptor::CreateShared(const VulkanSystem& system, VkDescriptorPool descriptorPool, VkDescriptorSetLayout otherDescriptorSetLayout, const std::string& debugName)
+void Descriptor::CreatePushDescriptor(VulkanSystem& system, const std::string& debugName)
+{
+	if (!system.PushDescriptorsSupported())
+		throw std::runtime_error("Push descriptors need VK_KHR_push_descriptor");
+	for (auto& binding : bindings)
+	{	// Not allowed in push descriptor layouts, the offset would have to be pushed instead
+		if (binding.descriptorType == VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC || binding.descriptorType == VK_DESCRIPTOR_TYPE_STORAGE_BUFFER_DYNAMIC)
+			throw std::runtime_error("Push descriptor " + debugName + " can't have dynamic buffers (binding " + std::to_string(binding.binding) + ")");
+	}
+
+	descriptorSetLayout = system.GetDescriptorSetLayout(bindings, debugName, VK_DESCRIPTOR_SET_LAYOUT_CREATE_PUSH_DESCRIPTOR_BIT_KHR);
+}
+
+void Descriptor::GetPushWrites(const void* data, size_t dataSize, std::vector<VkWriteDescriptorSet>& descriptorWrites) const
+{
+	descriptorWrites.clear();
+	size_t offset = 0;
+	for (auto& binding : bindings)
+	{
+		VkWriteDescriptorSet writeDS{ VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET };
+		writeDS.dstBinding = binding.binding;
+		writeDS.descriptorCount = binding.descriptorCount;
+		writeDS.descriptorType = binding.descriptorType;
+
+		size_t infoSize = GetPackedInfoSize(binding.descriptorType);
+		if (offset + infoSize * binding.descriptorCount > dataSize)
+			throw std::runtime_error("Push descriptor data is too small for the bindings");
+
+		const void* info = (const uint8_t*)data + offset;
+		switch (binding.descriptorType)	// Not on the size, the buffer and image infos are the same size
+		{
+		case VK_DESCRIPTOR_TYPE_UNIFORM_TEXEL_BUFFER:
+		case VK_DESCRIPTOR_TYPE_STORAGE_TEXEL_BUFFER:
+			writeDS.pTexelBufferView = (const VkBufferView*)info;
+			break;
+		case VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER:
+		case VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC:
+		case VK_DESCRIPTOR_TYPE_STORAGE_BUFFER:
+		case VK_DESCRIPTOR_TYPE_STORAGE_BUFFER_DYNAMIC:
+			writeDS.pBufferInfo = (const VkDescriptorBufferInfo*)info;
+			break;
+		default:
+			writeDS.pImageInfo = (const VkDescriptorImageInfo*)info;
+			break;
+		}
+		offset += infoSize * binding.descriptorCount;
+
+		descriptorWrites.push_back(writeDS);
+	}
+}
+
+bool Descriptor::CheckBindings(const ShaderReflection& reflection, const std::string& debugName, uint32_t set) const
+{
+	bool matches = true;
+	auto report = [&matches, &debugName](uint32_t binding, const std::string& problem)
+	{
+		WinUtils::OutputWarning("Descriptor " + debugName + " binding " + std::to_string(binding) + ": " + problem);
+		matches = false;
+	};
+
+	for (auto& used : reflection.GetBindings(set))
+	{
+		auto pos = std::find_if(bindings.begin(), bindings.end(), [&used](const auto& binding) { return binding.binding == used.binding; });
+		if (pos == bindings.end())
+		{
+			report(used.binding, "used by the shaders but not defined");
+			continue;
+		}
+		bool dynamicUniform = (used.descriptorType == VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER && pos->descriptorType == VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC);
+		if (pos->descriptorType != used.descriptorType && !dynamicUniform)
+			report(used.binding, "type doesn't match the shaders");
+		else if (pos->descriptorCount < used.descriptorCount)
+			report(used.binding, "fewer descriptors than the shaders use");
+		if ((pos->stageFlags & used.stageFlags) != used.stageFlags)
+			report(used.binding, "not visible to all the shader stages using it");
+	}
+	return matches;
+}
+
+void Descriptor::AddStorageBuffer(uint32_t binding, Buffer& buffer, VkShaderStageFlags stage)
+{
+	storageBuffers.push_back(&buffer);
+	AddBinding(binding, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, stage);
+}
+
+void Descriptor::AddBinding(uint32_t binding, VkDescriptorType type, VkShaderStageFlags stage, uint32_t count)
+{
+	VkDescriptorSetLayoutBinding layoutBinding{};
+	layoutBinding.binding = binding;
+	layoutBinding.descriptorType = type;
+	layoutBinding.descriptorCount = count;
+	layoutBinding.stageFlags = stage;
+	bindings.push_back(layoutBinding);
+}
+
+void Descriptor::CreateShared(const VulkanSystem& system, DescriptorAllocator& allocator, VkDescriptorSetLayout otherDescriptorSetLayout, const std::string& debugName)
 {
-	sharedDescriptorSetLayout = true;
 	descriptorSetLayout = otherDescriptorSetLayout;
-	CreateDescriptorSet(system, descriptorPool, 1/*numDescriptors*/, debugName);	// Just use single descriptors?
+	CreateDescriptorSet(system, allocator, 1/*numDescriptors*/, debugName);	// Just use single descriptors?
+}
+
+size_t Descriptor::GetPackedInfoSize(VkDescriptorType type)
+{
+	switch (type)
+	{
+	case VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER:
+	case VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC:
+	case VK_DESCRIPTOR_TYPE_STORAGE_BUFFER:
+	case VK_DESCRIPTOR_TYPE_STORAGE_BUFFER_DYNAMIC:
+		return sizeof(VkDescriptorBufferInfo);
+	case VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER:
+	case VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE:
+	case VK_DESCRIPTOR_TYPE_STORAGE_IMAGE:
+	case VK_DESCRIPTOR_TYPE_SAMPLER:
+	case VK_DESCRIPTOR_TYPE_INPUT_ATTACHMENT:
+		return sizeof(VkDescriptorImageInfo);
+	case VK_DESCRIPTOR_TYPE_UNIFORM_TEXEL_BUFFER:
+	case VK_DESCRIPTOR_TYPE_STORAGE_TEXEL_BUFFER:
+		return sizeof(VkBufferView);
+	default:
+		throw std::runtime_error("Unknown descriptor type");
+	}
+}
+
+void Descriptor::CreateUpdateTemplate(VulkanSystem& system, const std::string& debugName)
+{
+	std::vector<VkDescriptorUpdateTemplateEntry> entries;
+	size_t offset = 0;
+	for (auto& binding : bindings)
+	{
+		VkDescriptorUpdateTemplateEntry entry{};
+		entry.dstBinding = binding.binding;
+		entry.dstArrayElement = 0;
+		entry.descriptorCount = binding.descriptorCount;
+		entry.descriptorType = binding.descriptorType;
+		entry.offset = offset;
+		entry.stride = GetPackedInfoSize(binding.descriptorType);
+		offset += entry.stride * entry.descriptorCount;
+		entries.push_back(entry);
+	}
+
+	updateTemplateDataSize = offset;
+	if (!system.UpdateTemplatesSupported())
+		return;	// UpdateSetFromData falls back to writing the sets from the same data
+
+	VkDescriptorUpdateTemplateCreateInfo templateInfo{ VK_STRUCTURE_TYPE_DESCRIPTOR_UPDATE_TEMPLATE_CREATE_INFO };
+	templateInfo.descriptorUpdateEntryCount = (uint32_t)entries.size();
+	templateInfo.pDescriptorUpdateEntries = entries.data();
+	templateInfo.templateType = VK_DESCRIPTOR_UPDATE_TEMPLATE_TYPE_DESCRIPTOR_SET;
+	templateInfo.descriptorSetLayout = descriptorSetLayout;
+
+	CHECK_VULKAN_THROW(system.CreateDescriptorUpdateTemplate(templateInfo, &updateTemplate), "Failed to create descriptor update template");
+	system.DebugNameObject(updateTemplate, VK_OBJECT_TYPE_DESCRIPTOR_UPDATE_TEMPLATE, "Descriptor Update Template", debugName);
+}
+
+void Descriptor::UpdateSetFromData(const VulkanSystem& system, VkDescriptorSet descriptorSet, const void* data, size_t dataSize) const
+{
+	if (updateTemplateDataSize == 0)
+		throw std::runtime_error("Descriptor has no update template");
+	if (dataSize != updateTemplateDataSize)
+		throw std::runtime_error("Descriptor update data doesn't match the template");
+
+	if (updateTemplate != nullptr)
+		system.UpdateDescriptorSetWithTemplate(descriptorSet, updateTemplate, data);
+	else
+	{
+		std::vector<VkWriteDescriptorSet> descriptorWrites;
+		GetPushWrites(data, dataSize, descriptorWrites);
+		for (auto& writeDS : descriptorWrites)
+			writeDS.dstSet = descriptorSet;
+		vkUpdateDescriptorSets(system.GetDevice(), (uint32_t)descriptorWrites.size(), descriptorWrites.data(), 0, nullptr);
+	}
 }
 
 void Descriptor::Tidy(VulkanSystem& system)
 {
+	if (updateTemplate != nullptr)
+		system.DestroyDescriptorUpdateTemplate(updateTemplate);
+
 	for (auto buffer : uniformBuffers)
 		buffer->DestroyBuffer(system);
 	if (pDynamicUniformBuffer)
@@ -231,10 +474,7 @@ void Descriptor::Tidy(VulkanSystem& system)
 	for (auto& texture : textures)
 		texture->Tidy(system);
 
-	if (!sharedDescriptorSetLayout)
-		vkDestroyDescriptorSetLayout(system.GetDevice(), descriptorSetLayout, nullptr);
-
-	Reset();
+	Reset();	// Layout is owned by the system's layout cache
 }
 
 void Descriptor::AddTextureSampler(uint32_t binding, VkShaderStageFlags stage)
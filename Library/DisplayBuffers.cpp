@@ -39,7 +39,13 @@ void DisplayBuffers::CreateFrameBuffer(VulkanSystem& system, RenderPass& renderP
 				bool depthBufferAttachment = renderPass.IsInputAttachment(index);
 				if (depthBufferAttachment)
 					usage |= VK_IMAGE_USAGE_INPUT_ATTACHMENT_BIT;
-				depthImage.Create(system, depthBufferFormat, usage, extent.width, extent.height, 1, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, depthImageAspect, "DepthBuffer");
+				VkMemoryPropertyFlags memoryProperties = VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT;
+				if (renderPass.IsTransientAttachment(index))
+				{
+					usage |= VK_IMAGE_USAGE_TRANSIENT_ATTACHMENT_BIT;
+					memoryProperties |= VK_MEMORY_PROPERTY_LAZILY_ALLOCATED_BIT;
+				}
+				depthImage.Create(system, depthBufferFormat, usage, extent.width, extent.height, 1, memoryProperties, depthImageAspect, "DepthBuffer");
 
 				auto inc = system.GetScopedDebugOutputIncrement();
 				system.GetBufMan().TansitionImageLayout(system, system.GetGraphicsQueuePool(), depthImage.GetImage(), 1, depthBufferFormat, VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL);
@@ -56,19 +62,33 @@ void DisplayBuffers::CreateFrameBuffer(VulkanSystem& system, RenderPass& renderP
 		}
 		else
 		{	// Create an attachment image
+			auto& attachmentImages = attachmentImagesMap[index];
+			bool transient = renderPass.IsTransientAttachment(index);
+			if (transient && !attachmentImages.empty())
+			{	// Contents don't outlive the renderpass and frames are ordered by its external dependencies, so one image can be shared by all the framebuffers
+				bufAttachments.push_back(attachmentImages.front()->GetImageView());
+				continue;
+			}
+
 			ImageWithView* attachmentImage = new ImageWithView();
 			VkImageUsageFlags usage = VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT;
+			VkMemoryPropertyFlags memoryProperties = VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT;
 
 			if (renderPass.IsInputAttachment(index))
 				usage |= VK_IMAGE_USAGE_INPUT_ATTACHMENT_BIT;
-			else
+			if (transient)
+			{	// Only lives within the renderpass, so on tiled GPUs it can stay in tile memory
+				usage |= VK_IMAGE_USAGE_TRANSIENT_ATTACHMENT_BIT;
+				memoryProperties |= VK_MEMORY_PROPERTY_LAZILY_ALLOCATED_BIT;
+			}
+			else if (!renderPass.IsInputAttachment(index))
 				usage |= VK_IMAGE_USAGE_SAMPLED_BIT;	// Assume we are going to read from an off-screen buffer
 
-			attachmentImage->Create(system, renderPass.GetAttachmentFormat(index), usage, extent.width, extent.height, 1, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, VK_IMAGE_ASPECT_COLOR_BIT, renderPass.GetAttachmentDebugName(index));
+			attachmentImage->Create(system, renderPass.GetAttachmentFormat(index), usage, extent.width, extent.height, 1, memoryProperties, VK_IMAGE_ASPECT_COLOR_BIT, renderPass.GetAttachmentDebugName(index));
 
 			bufAttachments.push_back(attachmentImage->GetImageView());
 
-			attachmentImagesMap[index].push_back(attachmentImage);
+			attachmentImages.push_back(attachmentImage);
 		}
 	}
 
@@ -96,12 +116,19 @@ void DisplayBuffers::FreeCmdBuffers(VulkanSystem& system)
 	{
 		if (buffer.commandBuffer != nullptr)
 		{
+			system.GetGpuProfiler().FreeCommandBuffer(buffer.commandBuffer);
 			vkFreeCommandBuffers(system.GetDevice(), system.GetGraphicsQueuePool().GetPool(), 1, &buffer.commandBuffer);
 			buffer.commandBuffer = nullptr;
 		}
 	}
 }
 
+const ApiCallCounts& DisplayBuffers::GetApiCalls(uint32_t buffNum) const
+{
+	static const ApiCallCounts none;
+	return (buffNum < buffers.size()) ? buffers[buffNum].apiCalls : none;
+}
+
 void DisplayBuffers::CreateCmdBuffers(VulkanSystem& system, RenderPass& renderPass, std::function<void(VkCommandBuffer)> DrawFun, const std::string& debugName)
 {
 	FreeCmdBuffers(system);
@@ -129,11 +156,16 @@ void DisplayBuffers::CreateCmdBuffers(VulkanSystem& system, RenderPass& renderPa
 	for (auto& buffer : buffers)
 	{
 		CHECK_VULKAN(vkBeginCommandBuffer(buffer.commandBuffer, &commandBufferBeginInfo), "BeginCommandBuffer failed!");
+		system.GetGpuProfiler().BeginCommandBuffer(buffer.commandBuffer);
+		ApiCounters::BeginRecording(buffer.commandBuffer, buffer.apiCalls);
+		buffer.bindState.Begin(buffer.commandBuffer);
 
 		renderPass.Begin(buffer.frameBuffer, buffer.commandBuffer, extent);
 		DrawFun(buffer.commandBuffer);
 		renderPass.End(buffer.commandBuffer);
 
+		buffer.bindState.End();
+		ApiCounters::EndRecording();
 		CHECK_VULKAN(vkEndCommandBuffer(buffer.commandBuffer), "Failed to record command buffer!");
 	}
 }
@@ -150,10 +182,11 @@ void DisplayBuffers::SubmitCommandBuffer(uint32_t buffNum, VkQueue queue, const
 		waitStages.resize(waitSemaphores.size(), waitStage);
 		submitInfo.pWaitDstStageMask = waitStages.data();
 	}
-	if (buffers[buffNum].commandBuffer != nullptr)
+	if (GetCommandBuffer(buffNum) != nullptr)
 	{
 		submitInfo.commandBufferCount = 1;
 		submitInfo.pCommandBuffers = &buffers[buffNum].commandBuffer;
+		ApiCounters::Submitted(buffers[buffNum].apiCalls);
 	}
 	if (!signalSemaphores.empty())
 	{
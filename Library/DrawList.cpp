@@ -0,0 +1,90 @@
+#include "stdafx.h"
+#include "DrawList.h"
+#include "Pipeline.h"
+#include "Model.h"
+
+namespace
+{
+	// Small ids in order of first use, so the key has room for them
+	template <class T> uint64_t GetId(std::map<T, uint64_t>& ids, T object, uint64_t maxId)
+	{
+		auto pos = ids.insert({ object, ids.size() }).first;
+		return std::min(pos->second, maxId);
+	}
+}
+
+void DrawList::AddDraw(Pipeline& pipeline, VkDescriptorSet descriptorSet, Model& model, float depth, bool transparent, uint32_t dynamicOffset)
+{
+	packets.push_back(DrawPacket{ &pipeline, descriptorSet, dynamicOffset, &model, 1, {}, depth, transparent });
+}
+
+void DrawList::AddDrawWithPushConstantData(Pipeline& pipeline, VkDescriptorSet descriptorSet, Model& model, const void* data, size_t dataSize, float depth, bool transparent)
+{
+	auto bytes = (const uint8_t*)data;
+	Add(DrawPacket{ &pipeline, descriptorSet, INVALID_VALUE, &model, 1, std::vector<uint8_t>(bytes, bytes + dataSize), depth, transparent });
+}
+
+void DrawList::Add(DrawPacket packet)
+{
+	// Replay pushes the pipeline's size from the data, so anything else would read past it or leave some unset
+	if (!packet.pushConstants.empty() && packet.pushConstants.size() != packet.pipeline->GetPushConstantSize())
+		throw std::runtime_error("Draw's push constants (" + std::to_string(packet.pushConstants.size()) + " bytes) don't match the pipeline's (" + std::to_string(packet.pipeline->GetPushConstantSize()) + " bytes)");
+	packets.push_back(std::move(packet));
+}
+
+void DrawList::Sort()
+{
+	float minDepth = std::numeric_limits<float>::max(), maxDepth = std::numeric_limits<float>::lowest();
+	for (auto& packet : packets)
+	{
+		minDepth = std::min(minDepth, packet.depth);
+		maxDepth = std::max(maxDepth, packet.depth);
+	}
+	float depthScale = (maxDepth > minDepth) ? 1.0f / (maxDepth - minDepth) : 0.0f;
+
+	// Opaque:      0 | pipeline (15 bits) | descriptor set (16) | model (16) | depth (16)
+	// Transparent: 1 | far to near depth (32) | pipeline (15) | descriptor set (16)
+	std::map<Pipeline*, uint64_t> pipelineIds;
+	std::map<VkDescriptorSet, uint64_t> descriptorIds;
+	std::map<Model*, uint64_t> modelIds;
+	sortKeys.clear();
+	for (uint32_t index = 0; index < (uint32_t)packets.size(); index++)
+	{
+		auto& packet = packets[index];
+		uint64_t pipelineId = GetId(pipelineIds, packet.pipeline, 0x7FFF);
+		uint64_t descriptorId = GetId(descriptorIds, packet.descriptorSet, 0xFFFF);
+		double depth = (packet.depth - minDepth) * depthScale;	// 0 to 1
+		uint64_t key;
+		if (packet.transparent)
+			key = (1ull << 63) | ((uint64_t)((1.0 - depth) * 0xFFFFFFFF) << 31) | (pipelineId << 16) | descriptorId;
+		else
+			key = (pipelineId << 48) | (descriptorId << 32) | (GetId(modelIds, packet.model, 0xFFFF) << 16) | (uint64_t)(depth * 0xFFFF);
+		sortKeys.push_back({ key, index });
+	}
+	std::sort(sortKeys.begin(), sortKeys.end());	// Index breaks ties, so equal keys stay in the order added
+}
+
+void DrawList::Record(VkCommandBuffer commandBuffer)
+{
+	Sort();
+
+	Pipeline* boundPipeline = nullptr;
+	VkDescriptorSet boundDescriptorSet = nullptr;
+	uint32_t boundOffset = INVALID_VALUE;
+	Model* boundModel = nullptr;
+	for (auto& sortKey : sortKeys)
+	{
+		auto& packet = packets[sortKey.second];
+		if (packet.pipeline != boundPipeline || packet.descriptorSet != boundDescriptorSet || packet.dynamicOffset != boundOffset)
+		{
+			packet.pipeline->Bind(commandBuffer, packet.descriptorSet, packet.dynamicOffset);
+			boundPipeline = packet.pipeline;
+			boundDescriptorSet = packet.descriptorSet;
+			boundOffset = packet.dynamicOffset;
+		}
+		if (!packet.pushConstants.empty())
+			packet.pipeline->PushConstant(commandBuffer, packet.pushConstants.data());
+		packet.model->Draw(commandBuffer, packet.model != boundModel, packet.instanceCount);
+		boundModel = packet.model;
+	}
+}
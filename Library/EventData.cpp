@@ -1,12 +1,17 @@
 
 #include "stdafx.h"
 #include "EventData.h"
+#include <iomanip>
 
 constexpr auto KEY_LEFT_SHIFT = 340;
 constexpr auto KEY_RIGHT_SHIFT = 344;
 
 void EventData::UpdateKey(int key, int action)
 {
+	if (Ignore())
+		return;
+	RecordEvent('K', (float)key, (float)action);
+
 	if (key >= 0 && key < 1024)
 	{
 		if (action == KEY_DOWN)
@@ -59,6 +64,10 @@ bool EventData::KeyDown(int key) const
 
 void EventData::MousePress(int button, bool press)
 {
+	if (Ignore())
+		return;
+	RecordEvent('B', (float)button, press ? 1.0f : 0.0f);
+
 	if (press)
 	{
 		if (button == 0)
@@ -75,6 +84,10 @@ void EventData::MousePress(int button, bool press)
 
 void EventData::MouseMoved(float xpos, float ypos)
 {
+	if (Ignore())
+		return;
+	RecordEvent('M', xpos, ypos);
+
 	if (mouseData.mouseMode == MouseButton::None)
 		return;
 
@@ -103,3 +116,61 @@ bool EventData::GetMouseData(MouseData& data)
 	else
 		return false;
 }
+
+void EventData::MouseScroll(float yoffset)
+{
+	if (Ignore())
+		return;
+	RecordEvent('S', yoffset, 0.0f);
+
+	mouseData.scroll = yoffset;
+}
+
+bool EventData::StartRecording(const std::string& filename)
+{
+	recordFile.open(filename);
+	recordFile << std::setprecision(9);	// Exact floats
+	frame = 0;
+	return recordFile.good();
+}
+
+bool EventData::StartReplay(const std::string& filename)
+{
+	replayFile.open(filename);
+	frame = 0;
+	return ReadReplayEvent();
+}
+
+void EventData::RecordEvent(char type, float x, float y)
+{
+	if (recordFile.is_open())
+		recordFile << frame << ' ' << type << ' ' << x << ' ' << y << '\n';
+}
+
+bool EventData::ReadReplayEvent()
+{
+	if (!(replayFile >> replayEvent.frame >> replayEvent.type >> replayEvent.x >> replayEvent.y))
+	{
+		replayFile.close();	// Finished, back to live input
+		return false;
+	}
+	return true;
+}
+
+void EventData::NextFrame()
+{
+	frame++;
+	replayingEvent = true;
+	while (replayFile.is_open() && replayEvent.frame <= frame)
+	{
+		switch (replayEvent.type)
+		{
+		case 'K': UpdateKey((int)replayEvent.x, (int)replayEvent.y); break;
+		case 'B': MousePress((int)replayEvent.x, replayEvent.y != 0.0f); break;
+		case 'M': MouseMoved(replayEvent.x, replayEvent.y); break;
+		case 'S': MouseScroll(replayEvent.x); break;
+		}
+		ReadReplayEvent();
+	}
+	replayingEvent = false;
+}
@@ -7,6 +7,12 @@ void Extensions::Setup(const std::vector<const char *>& glfwExtensions)
 {
 	reqExtensions.insert(reqExtensions.begin(), glfwExtensions.begin(), glfwExtensions.end());
 	reqDeviceExtensions.push_back(VK_KHR_SWAPCHAIN_EXTENSION_NAME);
+	// For bindless textures
+	AddOptionalDeviceExtension(VK_KHR_MAINTENANCE3_EXTENSION_NAME);
+	AddOptionalDeviceExtension(VK_EXT_DESCRIPTOR_INDEXING_EXTENSION_NAME);
+	AddOptionalDeviceExtension(VK_KHR_PUSH_DESCRIPTOR_EXTENSION_NAME);	// For per draw descriptors
+	AddOptionalDeviceExtension(VK_KHR_DRAW_INDIRECT_COUNT_EXTENSION_NAME);	// For indirect draws that skip unused commands
+	AddOptionalDeviceExtension(VK_KHR_DESCRIPTOR_UPDATE_TEMPLATE_EXTENSION_NAME);	// Update templates on 1.0 devices
 
 	int showVulkanValidationMessages = VulkanPlayground::showVulkanValidationMessages;
 	if (VulkanPlayground::failVulkanCallsOnError)
@@ -150,3 +156,18 @@ bool Extensions::CheckIfDeviceExtensionEnabled(const char* extension) const
 {
 	return (std::find(reqDeviceExtensions.begin(), reqDeviceExtensions.end(), extension) != reqDeviceExtensions.end());
 }
+
+void Extensions::EnableOptionalDeviceExtensions(VkPhysicalDevice physicalDevice)
+{
+	uint32_t vkExtensionCount = 0;
+	CHECK_VULKAN(vkEnumerateDeviceExtensionProperties(physicalDevice, nullptr, &vkExtensionCount, nullptr), "Enumerating Device Extensions");
+	std::vector<VkExtensionProperties> vkExtensions(vkExtensionCount);
+	CHECK_VULKAN(vkEnumerateDeviceExtensionProperties(physicalDevice, nullptr, &vkExtensionCount, vkExtensions.data()), "Enumerating Device Extensions");
+
+	for (auto extension : optionalDeviceExtensions)
+	{
+		bool supported = std::find_if(vkExtensions.begin(), vkExtensions.end(), [extension](auto& elem) {return (elem.extensionName == std::string(extension)); }) != vkExtensions.end();
+		if (supported && !CheckIfDeviceExtensionEnabled(extension))
+			reqDeviceExtensions.push_back(extension);
+	}
+}
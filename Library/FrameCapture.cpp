@@ -0,0 +1,252 @@
+#include "stdafx.h"
+#include "FrameCapture.h"
+#include "System.h"
+#include "PixelData.h"
+#include <iomanip>
+
+namespace
+{
+	uint32_t Crc32(const uint8_t* data, size_t size, uint32_t crc = 0)
+	{
+		static uint32_t table[256] = {};
+		if (table[1] == 0)
+		{
+			for (uint32_t n = 0; n < 256; n++)
+			{
+				uint32_t c = n;
+				for (int bit = 0; bit < 8; bit++)
+					c = (c & 1) ? 0xEDB88320u ^ (c >> 1) : c >> 1;
+				table[n] = c;
+			}
+		}
+		crc = ~crc;
+		for (size_t i = 0; i < size; i++)
+			crc = table[(crc ^ data[i]) & 0xFF] ^ (crc >> 8);
+		return ~crc;
+	}
+
+	void AppendBigEndian(std::vector<uint8_t>& out, uint32_t value)
+	{
+		for (int shift = 24; shift >= 0; shift -= 8)
+			out.push_back((uint8_t)(value >> shift));
+	}
+
+	void WriteChunk(std::ofstream& file, const char* type, const std::vector<uint8_t>& data)
+	{
+		std::vector<uint8_t> chunk;
+		AppendBigEndian(chunk, (uint32_t)data.size());
+		chunk.insert(chunk.end(), type, type + 4);
+		chunk.insert(chunk.end(), data.begin(), data.end());
+		AppendBigEndian(chunk, Crc32(chunk.data() + 4, chunk.size() - 4));
+		file.write((const char*)chunk.data(), chunk.size());
+	}
+}
+
+bool ImageComparison::Passed(double allowedFraction) const
+{
+	return sizeMatches && differentPixels <= allowedFraction * (double)numPixels;
+}
+
+std::string ImageComparison::GetSummary() const
+{
+	if (!sizeMatches)
+		return "Size mismatch";
+	std::stringstream summary;
+	summary << std::fixed << std::setprecision(2) << differentPixels << " pixels differ, max " << maxDifference << ", RMSE " << rmse << ", PSNR " << psnr << "dB";
+	return summary.str();
+}
+
+void FrameCapture::Capture(VulkanSystem& system, VkImage image, VkFormat format, uint32_t _width, uint32_t _height, VkImageLayout layout)
+{
+	if (format != VK_FORMAT_B8G8R8A8_UNORM && format != VK_FORMAT_B8G8R8A8_SRGB && format != VK_FORMAT_R8G8B8A8_UNORM && format != VK_FORMAT_R8G8B8A8_SRGB)
+		throw std::runtime_error("Frame capture only supports 8 bit RGBA/BGRA images");
+	if (Pending())
+		FinishCopy(system);	// Only one capture in flight
+
+	width = _width;
+	height = _height;
+	swizzle = (format == VK_FORMAT_B8G8R8A8_UNORM || format == VK_FORMAT_B8G8R8A8_SRGB);
+	VkDeviceSize size = (VkDeviceSize)width * height * 4;
+	if (readback.GetBufferSize() != size)
+	{
+		readback.Create(system, size, VK_BUFFER_USAGE_TRANSFER_DST_BIT, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, "Frame Capture");
+		mappedPixels = readback.Map(system.GetDevice());
+	}
+
+	auto& queuePool = system.GetGraphicsQueuePool();
+	VkCommandBufferAllocateInfo allocateInfo{ VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO };
+	allocateInfo.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+	allocateInfo.commandPool = queuePool.GetPool();
+	allocateInfo.commandBufferCount = 1;
+	CHECK_VULKAN_THROW(vkAllocateCommandBuffers(system.GetDevice(), &allocateInfo, &commandBuffer), "Failed to allocate command buffers!");
+	system.DebugNameObject(commandBuffer, VK_OBJECT_TYPE_COMMAND_BUFFER, "CommandBuffer", "Frame Capture");
+
+	VkCommandBufferBeginInfo beginInfo{ VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO };
+	beginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+	CHECK_VULKAN_THROW(vkBeginCommandBuffer(commandBuffer, &beginInfo), "BeginCommandBuffer failed!");
+
+	// Wait for the rendering, copy, then put the image back how it was for the next frame
+	VkImageMemoryBarrier barrier{ VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER };
+	barrier.srcAccessMask = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT;
+	barrier.dstAccessMask = VK_ACCESS_TRANSFER_READ_BIT;
+	barrier.oldLayout = layout;
+	barrier.newLayout = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL;
+	barrier.srcQueueFamilyIndex = barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+	barrier.image = image;
+	barrier.subresourceRange = { VK_IMAGE_ASPECT_COLOR_BIT, 0, 1, 0, 1 };
+	vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT, 0, 0, nullptr, 0, nullptr, 1, &barrier);
+
+	VkBufferImageCopy region{};
+	region.imageSubresource = { VK_IMAGE_ASPECT_COLOR_BIT, 0, 0, 1 };
+	region.imageExtent = { width, height, 1 };
+	vkCmdCopyImageToBuffer(commandBuffer, image, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, readback.GetBuffer(), 1, &region);
+
+	VkBufferMemoryBarrier hostBarrier{ VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER };
+	hostBarrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+	hostBarrier.dstAccessMask = VK_ACCESS_HOST_READ_BIT;
+	hostBarrier.srcQueueFamilyIndex = hostBarrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+	hostBarrier.buffer = readback.GetBuffer();
+	hostBarrier.size = VK_WHOLE_SIZE;
+	std::swap(barrier.oldLayout, barrier.newLayout);
+	barrier.srcAccessMask = VK_ACCESS_TRANSFER_READ_BIT;
+	barrier.dstAccessMask = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT;
+	vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_HOST_BIT, 0, 0, nullptr, 1, &hostBarrier, 0, nullptr);
+	vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT, 0, 0, nullptr, 0, nullptr, 1, &barrier);
+	CHECK_VULKAN_THROW(vkEndCommandBuffer(commandBuffer), "EndCommandBuffer failed!");
+
+	VkFenceCreateInfo fenceInfo{ VK_STRUCTURE_TYPE_FENCE_CREATE_INFO };
+	CHECK_VULKAN_THROW(vkCreateFence(system.GetDevice(), &fenceInfo, nullptr, &fence), "Failed to create fence!");
+	system.DebugNameObject(fence, VK_OBJECT_TYPE_FENCE, "Fence", "Frame Capture");
+
+	VkSubmitInfo submitInfo{ VK_STRUCTURE_TYPE_SUBMIT_INFO };
+	submitInfo.commandBufferCount = 1;
+	submitInfo.pCommandBuffers = &commandBuffer;
+	CHECK_VULKAN_THROW(vkQueueSubmit(queuePool.GetQueue(), 1, &submitInfo, fence), "Failed to submit frame capture");	// After the frame on the same queue
+}
+
+bool FrameCapture::Ready(VulkanSystem& system)
+{
+	return Pending() && vkGetFenceStatus(system.GetDevice(), fence) == VK_SUCCESS;
+}
+
+void FrameCapture::FinishCopy(VulkanSystem& system)
+{
+	CHECK_VULKAN(vkWaitForFences(system.GetDevice(), 1, &fence, VK_TRUE, VulkanPlayground::NO_TIMEOUT), "Failed to wait for fence!");
+	vkDestroyFence(system.GetDevice(), fence, nullptr);
+	vkFreeCommandBuffers(system.GetDevice(), system.GetGraphicsQueuePool().GetPool(), 1, &commandBuffer);
+	fence = nullptr;
+	commandBuffer = nullptr;
+}
+
+bool FrameCapture::GetPixels(VulkanSystem& system, std::vector<uint8_t>& rgba)
+{
+	if (Pending())
+		FinishCopy(system);
+	if (mappedPixels == nullptr)
+		return false;
+
+	auto pixels = (const uint8_t*)mappedPixels;
+	rgba.assign(pixels, pixels + (size_t)width * height * 4);
+	if (swizzle)
+	{
+		for (size_t i = 0; i < rgba.size(); i += 4)
+			std::swap(rgba[i], rgba[i + 2]);
+	}
+	return true;
+}
+
+bool FrameCapture::SavePng(VulkanSystem& system, const std::string& filename)
+{
+	std::vector<uint8_t> rgba;
+	return GetPixels(system, rgba) && WritePng(filename, width, height, rgba.data());
+}
+
+ImageComparison FrameCapture::Compare(VulkanSystem& system, const std::string& goldenFile, uint32_t tolerance)
+{
+	std::vector<uint8_t> rgba;
+	if (!GetPixels(system, rgba))
+		throw std::runtime_error("Nothing captured to compare");
+
+	PixelData golden;
+	golden.Load(goldenFile);
+	return CompareImages(rgba.data(), width, height, golden.pixels, golden.width, golden.height, tolerance);
+}
+
+void FrameCapture::Tidy(VulkanSystem& system)
+{
+	if (Pending())
+		FinishCopy(system);
+	readback.DestroyBuffer(system);
+	mappedPixels = nullptr;
+}
+
+bool FrameCapture::WritePng(const std::string& filename, uint32_t width, uint32_t height, const uint8_t* rgba)
+{
+	std::ofstream file(filename, std::ios::binary);
+	if (!file)
+		return false;
+
+	// Uncompressed (stored) deflate blocks, bigger files but no compression library needed
+	size_t rowSize = (size_t)width * 4 + 1;	// Filter type byte first
+	std::vector<uint8_t> raw;
+	raw.reserve(rowSize * height);
+	for (uint32_t y = 0; y < height; y++)
+	{
+		raw.push_back(0);
+		raw.insert(raw.end(), rgba + y * (rowSize - 1), rgba + (y + 1) * (rowSize - 1));
+	}
+
+	std::vector<uint8_t> idat{ 0x78, 0x01 };	// zlib header
+	for (size_t pos = 0; pos < raw.size() || pos == 0; pos += 65535)
+	{
+		uint16_t blockSize = (uint16_t)std::min<size_t>(65535, raw.size() - pos);
+		idat.push_back(pos + blockSize >= raw.size() ? 1 : 0);	// Last block
+		idat.insert(idat.end(), { (uint8_t)blockSize, (uint8_t)(blockSize >> 8), (uint8_t)~blockSize, (uint8_t)(~blockSize >> 8) });
+		idat.insert(idat.end(), raw.begin() + pos, raw.begin() + pos + blockSize);
+	}
+	uint32_t a = 1, b = 0;	// Adler-32
+	for (auto byte : raw)
+	{
+		a = (a + byte) % 65521;
+		b = (b + a) % 65521;
+	}
+	AppendBigEndian(idat, (b << 16) | a);
+
+	std::vector<uint8_t> header;
+	AppendBigEndian(header, width);
+	AppendBigEndian(header, height);
+	header.insert(header.end(), { 8, 6, 0, 0, 0 });	// 8 bit RGBA, no interlacing
+
+	const uint8_t signature[] = { 0x89, 'P', 'N', 'G', '\r', '\n', 0x1A, '\n' };
+	file.write((const char*)signature, sizeof(signature));
+	WriteChunk(file, "IHDR", header);
+	WriteChunk(file, "IDAT", idat);
+	WriteChunk(file, "IEND", {});
+	return file.good();
+}
+
+ImageComparison FrameCapture::CompareImages(const uint8_t* rgba, uint32_t width, uint32_t height, const uint8_t* goldenRgba, uint32_t goldenWidth, uint32_t goldenHeight, uint32_t tolerance)
+{
+	uint64_t numPixels = (uint64_t)width * height;
+	ImageComparison comparison{ width == goldenWidth && height == goldenHeight, numPixels, 0, 0, 0.0, 0.0 };
+	if (!comparison.sizeMatches)
+		return comparison;
+
+	double sumSquares = 0.0;
+	for (uint64_t pixel = 0; pixel < numPixels; pixel++)
+	{
+		uint32_t pixelDifference = 0;
+		for (uint32_t channel = 0; channel < 4; channel++)
+		{
+			int difference = std::abs((int)rgba[pixel * 4 + channel] - (int)goldenRgba[pixel * 4 + channel]);
+			pixelDifference = std::max(pixelDifference, (uint32_t)difference);
+			sumSquares += difference * difference;
+		}
+		comparison.maxDifference = std::max(comparison.maxDifference, pixelDifference);
+		if (pixelDifference > tolerance)
+			comparison.differentPixels++;
+	}
+	comparison.rmse = std::sqrt(sumSquares / (numPixels * 4));
+	comparison.psnr = (comparison.rmse > 0.0) ? 20.0 * std::log10(255.0 / comparison.rmse) : std::numeric_limits<double>::infinity();
+	return comparison;
+}
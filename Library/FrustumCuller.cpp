@@ -0,0 +1,138 @@
+#include "stdafx.h"
+#include "FrustumCuller.h"
+#include "Model.h"
+#include "Camera.h"
+
+#if defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2) || defined(__SSE2__)
+#include <xmmintrin.h>
+#define FRUSTUM_CULLER_SSE
+#endif
+
+void FrustumCuller::Clear()
+{
+	for (auto component : { &centerX, &centerY, &centerZ, &sizeX, &sizeY, &sizeZ, &radius })
+		component->clear();
+	visible.clear();
+}
+
+uint32_t FrustumCuller::AddSphere(const glm::vec3& center, float sphereRadius)
+{
+	for (auto component : { &centerX, &centerY, &centerZ, &sizeX, &sizeY, &sizeZ, &radius })
+		component->push_back(0.0f);
+	uint32_t object = GetNumObjects() - 1;
+	SetSphere(object, center, sphereRadius);
+	return object;
+}
+
+uint32_t FrustumCuller::AddBox(const glm::vec3& min, const glm::vec3& max)
+{
+	uint32_t object = AddSphere(glm::vec3(0.0f), 0.0f);
+	SetBox(object, min, max);
+	return object;
+}
+
+uint32_t FrustumCuller::AddModel(Model& model, const glm::mat4& transform)
+{
+	// Transformed box is the moved center with each axis' half size spread over the absolute rotation and scale
+	glm::vec3 center = (model.GetMinExtent() + model.GetMaxExtent()) * 0.5f;
+	glm::vec3 halfSize = (model.GetMaxExtent() - model.GetMinExtent()) * 0.5f;
+	glm::vec3 newCenter = glm::vec3(transform * glm::vec4(center, 1.0f));
+	glm::vec3 newHalfSize = glm::mat3(glm::abs(transform[0]), glm::abs(transform[1]), glm::abs(transform[2])) * halfSize;
+	return AddBox(newCenter - newHalfSize, newCenter + newHalfSize);
+}
+
+void FrustumCuller::SetSphere(uint32_t object, const glm::vec3& center, float sphereRadius)
+{
+	centerX[object] = center.x;
+	centerY[object] = center.y;
+	centerZ[object] = center.z;
+	sizeX[object] = sizeY[object] = sizeZ[object] = 0.0f;
+	radius[object] = sphereRadius;
+}
+
+void FrustumCuller::SetBox(uint32_t object, const glm::vec3& min, const glm::vec3& max)
+{
+	glm::vec3 center = (min + max) * 0.5f, halfSize = (max - min) * 0.5f;
+	centerX[object] = center.x;
+	centerY[object] = center.y;
+	centerZ[object] = center.z;
+	sizeX[object] = halfSize.x;
+	sizeY[object] = halfSize.y;
+	sizeZ[object] = halfSize.z;
+	radius[object] = 0.0f;
+}
+
+std::array<glm::vec4, 6> FrustumCuller::ExtractPlanes(const glm::mat4& viewProjection)
+{
+	// Rows of the matrix (glm is column major), clip space is -w to w for x and y and 0 to w for z
+	glm::vec4 row[4];
+	for (int i = 0; i < 4; i++)
+		row[i] = glm::vec4(viewProjection[0][i], viewProjection[1][i], viewProjection[2][i], viewProjection[3][i]);
+
+	std::array<glm::vec4, 6> planes = { row[3] + row[0], row[3] - row[0], row[3] + row[1], row[3] - row[1], row[2], row[3] - row[2] };
+	for (auto& plane : planes)
+		plane /= glm::length(glm::vec3(plane));
+	return planes;
+}
+
+const std::vector<uint32_t>& FrustumCuller::Cull(const CameraOrientator& camera, const glm::mat4& projection)
+{
+	return Cull(projection * camera.CalcViewMatrix());
+}
+
+const std::vector<uint32_t>& FrustumCuller::Cull(const glm::mat4& viewProjection)
+{
+	// An object is outside when it's entirely behind any plane, i.e. the center's distance plus how far the volume reaches towards the plane is negative
+	auto planes = ExtractPlanes(viewProjection);
+	uint32_t numObjects = GetNumObjects();
+	visible.clear();
+	uint32_t object = 0;
+#ifdef FRUSTUM_CULLER_SSE
+	__m128 planeX[6], planeY[6], planeZ[6], planeD[6], absX[6], absY[6], absZ[6];
+	for (int plane = 0; plane < 6; plane++)
+	{
+		planeX[plane] = _mm_set1_ps(planes[plane].x);
+		planeY[plane] = _mm_set1_ps(planes[plane].y);
+		planeZ[plane] = _mm_set1_ps(planes[plane].z);
+		planeD[plane] = _mm_set1_ps(planes[plane].w);
+		absX[plane] = _mm_set1_ps(std::abs(planes[plane].x));
+		absY[plane] = _mm_set1_ps(std::abs(planes[plane].y));
+		absZ[plane] = _mm_set1_ps(std::abs(planes[plane].z));
+	}
+	const __m128 zero = _mm_setzero_ps();
+	for (; object + 4 <= numObjects; object += 4)
+	{
+		__m128 x = _mm_loadu_ps(&centerX[object]), y = _mm_loadu_ps(&centerY[object]), z = _mm_loadu_ps(&centerZ[object]);
+		__m128 sx = _mm_loadu_ps(&sizeX[object]), sy = _mm_loadu_ps(&sizeY[object]), sz = _mm_loadu_ps(&sizeZ[object]);
+		__m128 r = _mm_loadu_ps(&radius[object]);
+		__m128 outside = zero;
+		for (int plane = 0; plane < 6; plane++)
+		{
+			__m128 distance = _mm_add_ps(_mm_add_ps(_mm_mul_ps(planeX[plane], x), _mm_mul_ps(planeY[plane], y)), _mm_add_ps(_mm_mul_ps(planeZ[plane], z), planeD[plane]));
+			__m128 reach = _mm_add_ps(_mm_add_ps(_mm_mul_ps(absX[plane], sx), _mm_mul_ps(absY[plane], sy)), _mm_add_ps(_mm_mul_ps(absZ[plane], sz), r));
+			outside = _mm_or_ps(outside, _mm_cmplt_ps(_mm_add_ps(distance, reach), zero));
+		}
+		int outsideMask = _mm_movemask_ps(outside);
+		if (outsideMask == 0xF)
+			continue;	// The common case when zoomed in, nothing to add
+		for (uint32_t lane = 0; lane < 4; lane++)
+		{
+			if ((outsideMask & (1 << lane)) == 0)
+				visible.push_back(object + lane);
+		}
+	}
+#endif
+	for (; object < numObjects; object++)	// Whatever's left over from the batches
+	{
+		bool outside = false;
+		for (auto& plane : planes)
+		{
+			float distance = plane.x * centerX[object] + plane.y * centerY[object] + plane.z * centerZ[object] + plane.w;
+			float reach = std::abs(plane.x) * sizeX[object] + std::abs(plane.y) * sizeY[object] + std::abs(plane.z) * sizeZ[object] + radius[object];
+			outside |= (distance + reach < 0.0f);
+		}
+		if (!outside)
+			visible.push_back(object);
+	}
+	return visible;
+}
@@ -8,6 +8,7 @@
 
 #include "SwapChain.h"
 #include "RenderPass.h"
+#include "CpuProfiler.h"
 #include "Application.h"
 
 namespace glfwCallbacks
@@ -155,6 +156,8 @@ void GLFW::Init()
 
 bool GLFW::PollEvents(MouseData& mouseData)
 {
+	PROFILE_FUNCTION();
+	eventData.NextFrame();
 	glfwPollEvents();
 	return eventData.GetMouseData(mouseData);
 }
@@ -211,6 +214,19 @@ bool GLFW::CheckFoKeyPresses(VulkanApplication& app)
 			ToggleFullscreen();
 			return true;
 		}
+
+		if (KeyPressed(GLFW_KEY_F12))
+		{	// Start capturing, then write the trace on the second press
+			if (!CpuProfiler::Capturing())
+				CpuProfiler::StartCapture();
+			else
+			{
+				CpuProfiler::StopCapture();
+				const std::string traceFile = "CpuTrace.json";
+				if (CpuProfiler::WriteChromeTrace(traceFile))
+					std::cout << "CPU trace written to: " << traceFile << "\n";
+			}
+		}
 	}
 	return false;
 }
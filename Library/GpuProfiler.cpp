@@ -0,0 +1,154 @@
+#include "stdafx.h"
+#include "GpuProfiler.h"
+#include "System.h"
+#include <iomanip>
+
+void GpuProfiler::Create(VulkanSystem& system)
+{
+	uint32_t queueFamilyCount = 0;
+	vkGetPhysicalDeviceQueueFamilyProperties(system.GetPhysicalDevice(), &queueFamilyCount, nullptr);
+	std::vector<VkQueueFamilyProperties> queueFamilies(queueFamilyCount);
+	vkGetPhysicalDeviceQueueFamilyProperties(system.GetPhysicalDevice(), &queueFamilyCount, queueFamilies.data());
+	uint32_t validBits = queueFamilies[system.GetQueueIndicies().graphicsFamily].timestampValidBits;
+	if (validBits == 0)
+		return;	// No timing, regions are just labels
+
+	timestampMask = (validBits >= 64) ? ~0ull : ((1ull << validBits) - 1);
+	timestampPeriod = system.GetDeviceProperties().limits.timestampPeriod;
+
+	VkQueryPoolCreateInfo queryPoolInfo{ VK_STRUCTURE_TYPE_QUERY_POOL_CREATE_INFO };
+	queryPoolInfo.queryType = VK_QUERY_TYPE_TIMESTAMP;
+	queryPoolInfo.queryCount = queriesPerBlock * maxBlocks;
+	CHECK_VULKAN(vkCreateQueryPool(system.GetDevice(), &queryPoolInfo, nullptr, &queryPool), "Failed to create query pool!");
+	system.DebugNameObject(queryPool, VK_OBJECT_TYPE_QUERY_POOL, "QueryPool", "GPU Profiler");
+
+	// Reset everything up front so blocks that haven't been submitted yet read as unavailable
+	SingleCommand resetCmd(system, system.GetGraphicsQueuePool(), "Reset GPU Profiler");
+	vkCmdResetQueryPool(resetCmd.GetBuffer(), queryPool, 0, queryPoolInfo.queryCount);
+	resetCmd.Run(system);
+
+	for (uint32_t block = maxBlocks; block > 0; block--)
+		freeBlocks.push_back((block - 1) * queriesPerBlock);
+}
+
+void GpuProfiler::Tidy(VulkanSystem& system)
+{
+	if (queryPool != nullptr)
+		vkDestroyQueryPool(system.GetDevice(), queryPool, nullptr);
+	queryPool = nullptr;
+	blocks.clear();
+	freeBlocks.clear();
+	regionTimes.clear();
+}
+
+void GpuProfiler::BeginCommandBuffer(VkCommandBuffer commandBuffer)
+{
+	if (queryPool == nullptr)
+		return;
+
+	auto pos = blocks.find(commandBuffer);
+	if (pos == blocks.end())
+	{
+		if (freeBlocks.empty())
+			return;	// Too many command buffers, this one just isn't timed
+		pos = blocks.insert({ commandBuffer, Block{ freeBlocks.back(), 0 } }).first;
+		freeBlocks.pop_back();
+	}
+	auto& block = pos->second;
+	block.nextQuery = block.firstQuery;
+	block.regions.clear();
+	block.openRegions.clear();
+	vkCmdResetQueryPool(commandBuffer, queryPool, block.firstQuery, queriesPerBlock);	// Must be outside a render pass
+}
+
+void GpuProfiler::FreeCommandBuffer(VkCommandBuffer commandBuffer)
+{
+	auto pos = blocks.find(commandBuffer);
+	if (pos != blocks.end())
+	{
+		freeBlocks.push_back(pos->second.firstQuery);
+		blocks.erase(pos);
+	}
+}
+
+void GpuProfiler::StartRegion(VkCommandBuffer commandBuffer, const std::string& name)
+{
+	auto pos = blocks.find(commandBuffer);
+	if (pos == blocks.end())
+		return;
+
+	auto& block = pos->second;
+	if (block.nextQuery + 2 > block.firstQuery + queriesPerBlock)
+		return;	// Out of queries, not timed
+	block.openRegions.push_back(block.regions.size());
+	block.regions.push_back(Region{ name, block.nextQuery, INVALID_VALUE });
+	vkCmdWriteTimestamp(commandBuffer, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, queryPool, block.nextQuery++);
+	block.nextQuery++;	// Reserve the end query so nested regions can't use it up
+}
+
+void GpuProfiler::EndRegion(VkCommandBuffer commandBuffer)
+{
+	auto pos = blocks.find(commandBuffer);
+	if (pos == blocks.end() || pos->second.openRegions.empty())
+		return;
+
+	auto& block = pos->second;
+	auto& region = block.regions[block.openRegions.back()];
+	block.openRegions.pop_back();
+	region.endQuery = region.startQuery + 1;
+	vkCmdWriteTimestamp(commandBuffer, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, queryPool, region.endQuery);
+}
+
+void GpuProfiler::CollectResults(const VulkanSystem& system)
+{
+	std::vector<uint64_t> results;
+	for (auto& blockEntry : blocks)
+	{
+		auto& block = blockEntry.second;
+		uint32_t numQueries = block.nextQuery - block.firstQuery;
+		if (numQueries == 0)
+			continue;
+
+		// Value and availability pairs, regions whose queries aren't available yet are picked up on a later frame
+		results.assign(numQueries * 2, 0);
+		VkResult result = vkGetQueryPoolResults(system.GetDevice(), queryPool, block.firstQuery, numQueries, results.size() * sizeof(uint64_t), results.data(),
+			2 * sizeof(uint64_t), VK_QUERY_RESULT_64_BIT | VK_QUERY_RESULT_WITH_AVAILABILITY_BIT);
+		if (result != VK_SUCCESS && result != VK_NOT_READY)
+			continue;
+
+		std::map<std::string, float> frameTimes;
+		for (auto& region : block.regions)
+		{
+			if (region.endQuery == INVALID_VALUE)
+				continue;
+			uint32_t start = (region.startQuery - block.firstQuery) * 2, end = (region.endQuery - block.firstQuery) * 2;
+			if (results[start + 1] == 0 || results[end + 1] == 0)
+				continue;
+			uint64_t ticks = (results[end] - results[start]) & timestampMask;
+			frameTimes[region.name] += ticks * timestampPeriod / 1000000.0f;
+		}
+		for (auto& frameTime : frameTimes)
+		{
+			auto pos = regionTimes.find(frameTime.first);
+			if (pos == regionTimes.end())
+				regionTimes[frameTime.first] = frameTime.second;
+			else
+				pos->second += (frameTime.second - pos->second) * 0.05f;	// Smooth out the noise
+		}
+	}
+}
+
+float GpuProfiler::GetRegionTime(const std::string& name) const
+{
+	auto pos = regionTimes.find(name);
+	return (pos != regionTimes.end()) ? pos->second : 0.0f;
+}
+
+std::string GpuProfiler::GetSummary() const
+{
+	std::stringstream summary;
+	summary << std::fixed << std::setprecision(2);
+	for (auto& region : regionTimes)
+		summary << (summary.tellp() == 0 ? "GPU: " : ", ") << region.first << " " << region.second << "ms";
+	return summary.str();
+}
@@ -4,6 +4,7 @@
 #include "PixelData.h"
 #include "System.h"
 #include "WinUtil.h"
+#include "CpuProfiler.h"
 
 #pragma warning(push)
 #pragma warning(disable:26451 26495 6001 6262 6308 6387 28182 4310 4100)	// Disable some warnings in external code
@@ -14,6 +15,7 @@
 
 void PixelData::Load(const std::string& filename)
 {
+	PROFILE_FUNCTION();
 	int w, h, channelsInImage;
 	pixels = stbi_load(filename.c_str(), &w, &h, &channelsInImage, STBI_rgb_alpha);
 	width = w;
@@ -27,6 +29,7 @@ void PixelData::Load(const std::string& filename)
 
 void PixelData::LoadKTX(const std::string& filename)
 {
+	PROFILE_FUNCTION();
 	texture = new gli::texture2d(gli::load(filename.c_str()));
 
 	gli::texture2d &text2d = *((gli::texture2d*)texture);
@@ -39,6 +42,7 @@ void PixelData::LoadKTX(const std::string& filename)
 
 void PixelData::LoadKTXCube(const std::string& filename)
 {
+	PROFILE_FUNCTION();
 	isCube = true;
 	texture = new gli::texture_cube(gli::load(filename.c_str()));
 
@@ -52,6 +56,7 @@ void PixelData::LoadKTXCube(const std::string& filename)
 
 void PixelData::LoadKTXArray(const std::string& filename)
 {
+	PROFILE_FUNCTION();
 	texture = new gli::texture2d_array(gli::load(filename.c_str()));
 
 	width = texture->extent().x;
@@ -157,6 +162,7 @@ void PixelData::TidyUp()
 
 void Texture::Load(VulkanSystem& system, const std::string& filename, VkFormat format, bool createSampler)
 {
+	PROFILE_FUNCTION();
 	if (!WinUtils::FileExists(filename))
 		throw std::runtime_error("Texture file: " + filename + " does not exist");
 
@@ -177,6 +183,7 @@ void Texture::Load(VulkanSystem& system, const std::string& filename, VkFormat f
 
 void Texture::LoadCubeMap(VulkanSystem& system, const std::string& filename, VkFormat format)
 {
+	PROFILE_FUNCTION();
 	PixelData pd;
 	if (WinUtils::GetExtension(filename) == "ktx")
 		pd.LoadKTXCube(filename);
@@ -191,6 +198,7 @@ void Texture::LoadCubeMap(VulkanSystem& system, const std::string& filename, VkF
 
 void Texture::LoadArray(VulkanSystem& system, const std::string& filename, VkFormat format)
 {
+	PROFILE_FUNCTION();
 	PixelData pd;
 	if (WinUtils::GetExtension(filename) == "ktx")
 		pd.LoadKTXArray(filename);
@@ -225,6 +233,7 @@ void Texture::Create3dTexture(VulkanSystem& system, PixelData& pd, VkFormat form
 
 void Texture::Load3dTexture(VulkanSystem& system, const std::string& filename, VkFormat format)
 {
+	PROFILE_FUNCTION();
 	PixelData pd;
 	if (WinUtils::GetExtension(filename) == "ktx")
 		pd.LoadKTXArray(filename);
@@ -324,9 +333,13 @@ void Image::Create(VulkanSystem& system, VkFormat format, VkImageUsageFlags usag
 
 	VkMemoryAllocateInfo allocateInfo{ VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO };
 	allocateInfo.allocationSize = memRequirements.size;
+	if ((properties & VK_MEMORY_PROPERTY_LAZILY_ALLOCATED_BIT) && !system.HasMemoryType(memRequirements.memoryTypeBits, properties))
+		properties &= ~VK_MEMORY_PROPERTY_LAZILY_ALLOCATED_BIT;	// Generally only tiled GPUs support it
 	allocateInfo.memoryTypeIndex = system.FindMemoryType(memRequirements.memoryTypeBits, properties);
 
 	CHECK_VULKAN(vkAllocateMemory(system.GetDevice(), &allocateInfo, nullptr, &deviceMemory), "Failed to allocate buffer memory");
+	allocationSize = allocateInfo.allocationSize;
+	system.MemoryAllocated(allocationSize);
 	CHECK_VULKAN(vkBindImageMemory(system.GetDevice(), image, deviceMemory, 0), "Failed to bind buffer");
 	system.DebugNameObject(GetDeviceMemory(), VK_OBJECT_TYPE_DEVICE_MEMORY, "ImageMem ", debugName);
 
@@ -349,8 +362,20 @@ void ImageWithView::Tidy(VulkanSystem& system)
 	image.DestroyBuffer(system);
 }
 
+uint32_t TextureBase::GetBindlessIndex(VulkanSystem& system)
+{
+	if (bindlessIndex == INVALID_VALUE)
+		bindlessIndex = system.GetBindlessTextures().Register(system, *this);
+	return bindlessIndex;
+}
+
 void TextureBase::Tidy(VulkanSystem& system)
 {
+	if (bindlessIndex != INVALID_VALUE)
+	{
+		system.UnregisterBindlessTexture(bindlessIndex);
+		bindlessIndex = INVALID_VALUE;
+	}
 	if (textureSampler != nullptr)
 	{
 		vkDestroySampler(system.GetDevice(), textureSampler, nullptr);
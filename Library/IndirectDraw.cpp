@@ -0,0 +1,132 @@
+#include "stdafx.h"
+#include "IndirectDraw.h"
+#include "System.h"
+#include "Model.h"
+#include "BindState.h"
+
+uint32_t IndirectDraw::AddMesh(const Model& model)
+{
+	if (Created())
+		throw std::runtime_error("Indirect draw meshes must be added before it's created");
+	if (vertexStride != 0 && model.vertexStride != vertexStride)
+		throw std::runtime_error("Indirect draw meshes must all have the same vertex layout");
+	vertexStride = model.vertexStride;
+
+	Mesh mesh{ 0, (uint32_t)indices.size(), (int32_t)(vertices.size() / vertexStride) };
+	if (model.useIndices)
+		indices.insert(indices.end(), model.indices.begin(), model.indices.end());
+	else
+	{
+		for (uint32_t index = 0; index < model.GetNumVertices(); index++)
+			indices.push_back(index);
+	}
+	mesh.indexCount = (uint32_t)indices.size() - mesh.firstIndex;
+	vertices.insert(vertices.end(), model.vertices.begin(), model.vertices.end());
+	meshes.push_back(mesh);
+	return (uint32_t)meshes.size() - 1;
+}
+
+void IndirectDraw::Create(VulkanSystem& system, uint32_t maxNumDraws, uint32_t maxNumInstances, uint32_t dataSizePerInstance, const std::string& debugName)
+{
+	if (meshes.empty())
+		throw std::runtime_error("No meshes to draw indirectly");
+	auto& features = system.GetEnabledDeviceFeatures();
+	if (!features.drawIndirectFirstInstance)
+		throw std::runtime_error("Indirect drawing not enabled, see VulkanPlayground::EnableIndirectDrawing");
+	// Both the draw count and multi draw are limited to maxDrawIndirectCount draws (1 without multiDrawIndirect), beyond that it's an indirect draw per command
+	bool batched = (maxNumDraws <= system.GetDeviceProperties().limits.maxDrawIndirectCount);
+	cmdDrawIndexedIndirectCount = batched ? system.GetDrawIndexedIndirectCount() : nullptr;
+	multiDraw = batched && features.multiDrawIndirect;
+	maxDraws = maxNumDraws;
+	maxInstances = maxNumInstances;
+	instanceDataSize = dataSizePerInstance;
+
+	system.CreateGpuBuffer(system, vertexBuffer, vertices, VK_BUFFER_USAGE_VERTEX_BUFFER_BIT, "Indirect Verticies [" + debugName + "]");
+	system.CreateGpuBuffer(system, indexBuffer, indices, VK_BUFFER_USAGE_INDEX_BUFFER_BIT, "Indirect Indicies [" + debugName + "]");
+	vertices.clear();
+	indices.clear();
+
+	VkDeviceSize commandsSize = sizeof(VkDrawIndexedIndirectCommand) * maxDraws;
+	drawBuffer.Create(system, commandsSize + sizeof(uint32_t), VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, "Indirect Draws [" + debugName + "]");
+	instanceBuffer.Create(system, (VkDeviceSize)maxInstances * instanceDataSize, VK_BUFFER_USAGE_STORAGE_BUFFER_BIT, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, "Indirect Instances [" + debugName + "]");
+
+	auto drawData = (char*)drawBuffer.Map(system.GetDevice());
+	memset(drawData, 0, (size_t)drawBuffer.GetBufferSize());	// No instances, so nothing drawn until the first End
+	commands = (VkDrawIndexedIndirectCommand*)drawData;
+	drawCount = (uint32_t*)(drawData + commandsSize);
+	instanceData = (char*)instanceBuffer.Map(system.GetDevice());
+	numDraws = numInstances = clearedDraws = 0;
+}
+
+void IndirectDraw::Tidy(VulkanSystem& system)
+{
+	vertexBuffer.DestroyBuffer(system);
+	indexBuffer.DestroyBuffer(system);
+	drawBuffer.DestroyBuffer(system);	// Also unmaps
+	instanceBuffer.DestroyBuffer(system);
+	commands = nullptr;
+	drawCount = nullptr;
+	instanceData = nullptr;
+	cmdDrawIndexedIndirectCount = nullptr;
+	meshes.clear();
+	vertices.clear();
+	indices.clear();
+	vertexStride = 0;
+}
+
+void IndirectDraw::Begin()
+{
+	numDraws = 0;
+	numInstances = 0;
+}
+
+void* IndirectDraw::AddDraw(uint32_t mesh, uint32_t instanceCount)
+{
+	if (mesh >= meshes.size())
+		throw std::runtime_error("Unknown indirect draw mesh");
+	if (numDraws == maxDraws || numInstances + instanceCount > maxInstances)
+		return nullptr;
+
+	auto& command = commands[numDraws++];
+	command.indexCount = meshes[mesh].indexCount;
+	command.instanceCount = instanceCount;
+	command.firstIndex = meshes[mesh].firstIndex;
+	command.vertexOffset = meshes[mesh].vertexOffset;
+	command.firstInstance = numInstances;	// gl_InstanceIndex starts here
+
+	void* data = instanceData + (size_t)numInstances * instanceDataSize;
+	numInstances += instanceCount;
+	return data;
+}
+
+void IndirectDraw::End()
+{
+	if (!Created())
+		throw std::runtime_error("Indirect draw must be created before it's used");
+	// Commands left from a previous frame still have instances, which only matters without the draw count
+	for (uint32_t draw = numDraws; draw < clearedDraws; draw++)
+		commands[draw].instanceCount = 0;
+	clearedDraws = numDraws;
+	*drawCount = numDraws;
+}
+
+void IndirectDraw::Record(VkCommandBuffer commandBuffer)
+{
+	BindState::CmdBindVertexBuffers(commandBuffer, 0, 1, &vertexBuffer.GetBuffer(), VulkanPlayground::zeroOffset);
+	BindState::CmdBindIndexBuffer(commandBuffer, indexBuffer.GetBuffer(), 0, VK_INDEX_TYPE_UINT32);
+
+	// Always recorded for the maximum number of draws, what's actually drawn is read from the buffer when the command buffer runs
+	uint32_t stride = sizeof(VkDrawIndexedIndirectCommand);
+	if (cmdDrawIndexedIndirectCount != nullptr)
+	{
+		ApiCounters::RecordCommand(commandBuffer, ApiCall::DrawIndexedIndirect);
+		cmdDrawIndexedIndirectCount(commandBuffer, drawBuffer.GetBuffer(), 0, drawBuffer.GetBuffer(), stride * maxDraws, maxDraws, stride);
+	}
+	else if (multiDraw)
+		vkCmdDrawIndexedIndirect(commandBuffer, drawBuffer.GetBuffer(), 0, maxDraws, stride);
+	else
+	{
+		for (uint32_t draw = 0; draw < maxDraws; draw++)
+			vkCmdDrawIndexedIndirect(commandBuffer, drawBuffer.GetBuffer(), draw * stride, 1, stride);
+	}
+}
@@ -6,9 +6,12 @@
 #include "System.h"
 #include "EventData.h"
 #include "Camera.h"
+#include "CpuProfiler.h"
+#include "BindState.h"
 
 void Model::LoadToGpu(VulkanSystem& system, const std::string& modelFilename, const std::vector<Attribs::Attrib>& attribs)
 {
+	PROFILE_FUNCTION();
 	attribsUsed = attribs;
 
 	if (vertices.empty())
@@ -20,6 +23,7 @@ void Model::LoadToGpu(VulkanSystem& system, const std::string& modelFilename, co
 
 void Model::Load(const std::string& modelFilename, const std::vector<Attribs::Attrib>& attribs)
 {
+	PROFILE_FUNCTION();
 	vertexStride = Attribs::GetStride(attribs);
 
 	auto tStart = std::chrono::high_resolution_clock::now();
@@ -66,9 +70,9 @@ void Model::Draw(VkCommandBuffer commandBuffer, bool bindBuffers, uint32_t insta
 {
 	if (bindBuffers)
 	{
-		vkCmdBindVertexBuffers(commandBuffer, 0, 1, &vertexBuffer.GetBuffer(), VulkanPlayground::zeroOffset);
+		BindState::CmdBindVertexBuffers(commandBuffer, 0, 1, &vertexBuffer.GetBuffer(), VulkanPlayground::zeroOffset);
 		if (useIndices)
-			vkCmdBindIndexBuffer(commandBuffer, indexBuffer.GetBuffer(), 0, VK_INDEX_TYPE_UINT32);
+			BindState::CmdBindIndexBuffer(commandBuffer, indexBuffer.GetBuffer(), 0, VK_INDEX_TYPE_UINT32);
 	}
 	if (useIndices)
 		vkCmdDrawIndexed(commandBuffer, (uint32_t)indices.size(), instanceCount, 0, 0, 0);
@@ -4,6 +4,11 @@
 #include "RenderPass.h"
 #include "Shader.h"
 #include "Descriptor.h"
+#include "CpuProfiler.h"
+#include "BindState.h"
+#include <future>
+#include <atomic>
+#include <thread>
 
 void Pipeline::SetViewPort(const VkRect2D& rect)
 {
@@ -18,34 +23,52 @@ void Pipeline::SetScissorRect(const VkRect2D& rect)
 	scissor = rect;
 }
 
-Shader& Pipeline::LoadShaderDiffNames(VulkanSystem& system, const std::string& vertexShader, const std::string& fragmentShader, const std::string& geometryShader, const std::string& dirHint)
+Shader& Pipeline::LoadShaderDiffNames(VulkanSystem& system, const std::string& vertexShader, const std::string& fragmentShader, const std::string& geometryShader, const std::string& dirHint, const std::vector<std::string>& defines)
 {
 	auto vertexFile = vertexShader.empty() ? "" : (dirHint + "\\" + vertexShader);
 	auto fragmentFile = fragmentShader.empty() ? "" : (dirHint + "\\" + fragmentShader);
 	auto geomFile = geometryShader.empty() ? "" : (dirHint + "\\" + geometryShader);
-	shader.Load(system, vertexFile, fragmentFile, geomFile);
+	shader.Load(system, vertexFile, fragmentFile, geomFile, defines);
 	return shader;
 }
 
-void Pipeline::AddPushConstant(VulkanSystem& system, uint32_t dataSize, VkShaderStageFlagBits stage)
+void Pipeline::AddPushConstant(VulkanSystem& system, uint32_t dataSize, VkShaderStageFlags stage, uint32_t offset)
 {
 	// Check requested push constant size against hardware limit
 	// Specs require 128 bytes, so if the device complies our push constant buffer should always fit into memory		
-	if (dataSize > system.GetDeviceProperties().limits.maxPushConstantsSize)
+	if (offset + dataSize > system.GetDeviceProperties().limits.maxPushConstantsSize)
 		throw std::runtime_error("Push constant too big!");
 
 	pushConstantRange.stageFlags = stage;
-	pushConstantRange.offset = 0;
+	pushConstantRange.offset = offset;
 	pushConstantRange.size = dataSize;
 }
 
+void Pipeline::UseReflectedPushConstants(VulkanSystem& system)
+{
+	auto& range = shader.GetReflection().GetPushConstantRange();
+	if (range.size > 0)
+		AddPushConstant(system, range.size, range.stageFlags, range.offset);
+}
+
+VkDescriptorSetLayout Pipeline::GetReflectedDescriptorSetLayout(VulkanSystem& system, const std::string& debugName, uint32_t set) const
+{
+	auto bindings = shader.GetReflection().GetBindings(set);
+	for (auto& binding : bindings)
+	{
+		if (binding.descriptorCount == 0)
+			throw std::runtime_error("Reflected layout can't be used with runtime sized arrays: " + debugName);
+	}
+	return system.GetDescriptorSetLayout(bindings, debugName);
+}
+
 void Pipeline::PushConstant(VkCommandBuffer commandBuffer, const void* data)
 {
-	vkCmdPushConstants(commandBuffer, pipelineLayout, pushConstantRange.stageFlags, pushConstantRange.offset, pushConstantRange.size, data);
+	BindState::CmdPushConstants(commandBuffer, pipelineLayout, pushConstantRange.stageFlags, pushConstantRange.offset, pushConstantRange.size, data);
 }
 
 Pipeline::Pipeline()
-	: pipelineLayout(nullptr), pipeline(nullptr), recreate(false)
+	: pipelineLayout(nullptr), pipeline(nullptr), cmdPushDescriptorSet(nullptr), recreate(false), descriptorSetLayoutUsed(nullptr), basePipeline(nullptr), specializationChanged(false), primaryPipeline(nullptr), reloadLayout(nullptr)
 {
 	inputAssembly.topology = VK_PRIMITIVE_TOPOLOGY_TRIANGLE_LIST;
 	inputAssembly.primitiveRestartEnable = VK_FALSE;
@@ -85,8 +108,26 @@ Pipeline::Pipeline()
 	depthStencil.back = {};
 }
 
+Pipeline::~Pipeline()
+{	// Normally already waited for by Tidy, but the background tasks use this pipeline so mustn't outlive it
+	if (prewarmTask.valid())
+		prewarmTask.wait();
+	if (reloadTask.valid())
+		reloadTask.wait();
+}
+
 void Pipeline::Create(VulkanSystem& system, VkDescriptorSetLayout descriptorSetLayout, const RenderPass& renderPass, const std::string& debugName)
 {
+	Prepare(system, descriptorSetLayout, renderPass, debugName);
+	Build(system);
+	CompleteCreation(system);
+}
+
+void Pipeline::Prepare(VulkanSystem& system, VkDescriptorSetLayout descriptorSetLayout, const RenderPass& renderPass, const std::string& debugName)
+{
+	name = debugName;
+	cmdPushDescriptorSet = system.GetCmdPushDescriptorSet();
+
 	pipelineInfo.pVertexInputState = &vertexInputInfo;
 	pipelineInfo.pInputAssemblyState = &inputAssembly;
 	pipelineInfo.pViewportState = &viewportState;
@@ -117,50 +158,312 @@ void Pipeline::Create(VulkanSystem& system, VkDescriptorSetLayout descriptorSetL
 		vertexInputInfo.pVertexAttributeDescriptions = vertexDescription.attributeDescriptions.data();
 	}
 
+	pipelineInfo.stageCount = shader.NumShaders();
+	if (pipelineInfo.stageCount > 0)
+		pipelineInfo.pStages = shader.StageData();
+
+	// Kept as a member (rather than on the stack) so the create info stays valid until the pipeline is built
+	pipelineInfo.pDynamicState = nullptr;
+	if (!dynamicStateEnables.empty())
+	{
+		dynamicState.pDynamicStates = dynamicStateEnables.data();
+		dynamicState.dynamicStateCount = (uint32_t)(dynamicStateEnables.size());
+		dynamicState.flags = 0;
+		pipelineInfo.pDynamicState = &dynamicState;
+	}
+	pipelineInfo.renderPass = renderPass.Get();
+	descriptorSetLayoutUsed = descriptorSetLayout;
+
+	SetupStateKey(system, descriptorSetLayout, renderPass);
+	if (!stateKey.empty() && system.FindPipeline(stateKey, pipeline, pipelineLayout))
+	{
+		pipelineInfo.layout = pipelineLayout;	// Still needed if a variant's built from the info later
+		return;	// Identical pipeline already exists
+	}
+
+	pipelineLayout = CreatePipelineLayout(system);
+	pipelineInfo.layout = pipelineLayout;
+}
+
+VkPipelineLayout Pipeline::CreatePipelineLayout(VulkanSystem& system) const
+{
+	std::vector<VkDescriptorSetLayout> setLayouts;
+	if (descriptorSetLayoutUsed != nullptr)
+		setLayouts.push_back(descriptorSetLayoutUsed);
+	setLayouts.insert(setLayouts.end(), extraDescriptorSetLayouts.begin(), extraDescriptorSetLayouts.end());
+
 	VkPipelineLayoutCreateInfo pipelineLayoutInfo{ VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO };
-	if (descriptorSetLayout != nullptr)
+	if (!setLayouts.empty())
 	{
-		pipelineLayoutInfo.setLayoutCount = 1;
-		pipelineLayoutInfo.pSetLayouts = &descriptorSetLayout;
-		descriptorSetLayoutUsed = descriptorSetLayout;
+		pipelineLayoutInfo.setLayoutCount = (uint32_t)setLayouts.size();
+		pipelineLayoutInfo.pSetLayouts = setLayouts.data();
 	}
 	if (pushConstantRange.size > 0)
 	{
 		pipelineLayoutInfo.pushConstantRangeCount = 1;
 		pipelineLayoutInfo.pPushConstantRanges = &pushConstantRange;
 	}
-	CHECK_VULKAN(vkCreatePipelineLayout(system.GetDevice(), &pipelineLayoutInfo, nullptr, &pipelineLayout), "Failed to createpipeline layout!");
+	VkPipelineLayout layout;
+	CHECK_VULKAN(vkCreatePipelineLayout(system.GetDevice(), &pipelineLayoutInfo, nullptr, &layout), "Failed to createpipeline layout!");
+	return layout;
+}
 
-	pipelineInfo.stageCount = shader.NumShaders();
-	if (pipelineInfo.stageCount > 0)
-		pipelineInfo.pStages = shader.StageData();
+void Pipeline::SetupStateKey(const VulkanSystem& system, VkDescriptorSetLayout descriptorSetLayout, const RenderPass& renderPass)
+{
+	stateKey = StateKey();
 
-	VkPipelineDynamicStateCreateInfo pipelineDynamicStateCreateInfo{ VK_STRUCTURE_TYPE_PIPELINE_DYNAMIC_STATE_CREATE_INFO };
-	if (!dynamicStateEnables.empty())
+	// Layouts are compatible if their descriptor set layouts are identically defined, unknown layouts can't be matched so don't share
+	const StateKey* layoutKey = nullptr;
+	if (descriptorSetLayout != nullptr)
 	{
-		pipelineDynamicStateCreateInfo.pDynamicStates = dynamicStateEnables.data();
-		pipelineDynamicStateCreateInfo.dynamicStateCount = (uint32_t)(dynamicStateEnables.size());
-		pipelineDynamicStateCreateInfo.flags = 0;
-		pipelineInfo.pDynamicState = &pipelineDynamicStateCreateInfo;
+		layoutKey = system.GetDescriptorSetLayoutKey(descriptorSetLayout);
+		if (layoutKey == nullptr)
+			return;
 	}
-	pipelineInfo.layout = pipelineLayout;
-	pipelineInfo.renderPass = renderPass.Get();
-	CHECK_VULKAN(vkCreateGraphicsPipelines(system.GetDevice(), VK_NULL_HANDLE, 1, &pipelineInfo, nullptr, &pipeline), "Failed to create graphics pipeline!");
 
-	system.DebugNameObject(pipeline, VK_OBJECT_TYPE_PIPELINE, "Pipeline", debugName);
+	StateKey key;
+	key.Add(renderPass.GetCompatibilityKey()).Add(pipelineInfo.subpass).Add(pipelineInfo.flags);
+	key.Add(layoutKey != nullptr ? *layoutKey : StateKey()).Add(pushConstantRange);
+	for (auto layout : extraDescriptorSetLayouts)
+		key.Add(layout);	// Extra layouts are long lived (e.g. bindless table), so the handle identifies them
+
+	for (uint32_t stage = 0; stage < pipelineInfo.stageCount; stage++)
+	{
+		const auto& stageInfo = pipelineInfo.pStages[stage];
+		key.Add(stageInfo.stage).Add(stageInfo.module).Add(std::string(stageInfo.pName));
+		if (stageInfo.pSpecializationInfo != nullptr)
+		{
+			const auto& specInfo = *stageInfo.pSpecializationInfo;
+			key.Add(specInfo.mapEntryCount).AddData(specInfo.pMapEntries, sizeof(VkSpecializationMapEntry) * specInfo.mapEntryCount);
+			key.Add(specInfo.dataSize).AddData(specInfo.pData, specInfo.dataSize);
+		}
+	}
+
+	key.Add(vertexInputInfo.vertexAttributeDescriptionCount);
+	if (vertexInputInfo.vertexAttributeDescriptionCount > 0)
+	{
+		key.Add(vertexDescription.bindingDescription);
+		for (auto& attrib : vertexDescription.attributeDescriptions)
+			key.Add(attrib);
+	}
+	key.Add(inputAssembly.topology).Add(inputAssembly.primitiveRestartEnable);
+
+	key.Add(dynamicStateEnables.size());
+	for (auto state : dynamicStateEnables)
+		key.Add(state);
+	if (!IsDynamicStateEnabled(VK_DYNAMIC_STATE_VIEWPORT))
+		key.Add(viewport);
+	if (!IsDynamicStateEnabled(VK_DYNAMIC_STATE_SCISSOR))
+		key.Add(scissor);
+
+	key.Add(rasterizer.depthClampEnable).Add(rasterizer.rasterizerDiscardEnable).Add(rasterizer.polygonMode).Add(rasterizer.cullMode).Add(rasterizer.frontFace);
+	key.Add(rasterizer.depthBiasEnable).Add(rasterizer.depthBiasConstantFactor).Add(rasterizer.depthBiasClamp).Add(rasterizer.depthBiasSlopeFactor).Add(rasterizer.lineWidth);
+	key.Add(multisampling.rasterizationSamples).Add(multisampling.sampleShadingEnable).Add(multisampling.minSampleShading).Add(multisampling.alphaToCoverageEnable).Add(multisampling.alphaToOneEnable);
+
+	key.Add(colorBlending.logicOpEnable).Add(colorBlending.logicOp).Add(colorBlending.attachmentCount).Add(colorBlending.blendConstants);
+	for (uint32_t attachment = 0; attachment < colorBlending.attachmentCount; attachment++)
+		key.Add(colorBlendAttachments[attachment]);
+
+	key.Add(pipelineInfo.pDepthStencilState != nullptr);
+	if (pipelineInfo.pDepthStencilState != nullptr)
+	{
+		key.Add(depthStencil.depthTestEnable).Add(depthStencil.depthWriteEnable).Add(depthStencil.depthCompareOp).Add(depthStencil.depthBoundsTestEnable);
+		key.Add(depthStencil.stencilTestEnable).Add(depthStencil.front).Add(depthStencil.back).Add(depthStencil.minDepthBounds).Add(depthStencil.maxDepthBounds);
+	}
+
+	stateKey = key;
+}
+
+void Pipeline::Build(VulkanSystem& system)
+{	// Called from worker threads when creating in bulk, debug naming is done afterwards on the main thread
+	PROFILE_FUNCTION();
+	if (pipeline != nullptr)
+		return;	// Found in pipeline cache
+
+	if (basePipeline != nullptr)
+		pipelineInfo.basePipelineHandle = basePipeline->pipeline;
+	VkResult result = vkCreateGraphicsPipelines(system.GetDevice(), system.GetPipelineCache(), 1, &pipelineInfo, nullptr, &pipeline);
+	if (!CHECK_VULKAN(result, "Failed to create graphics pipeline!"))
+		throw std::runtime_error("Failed to create graphics pipeline " + name + " (" + std::to_string(result) + ")");	// Also in release, rather than carrying on with a null pipeline
+}
+
+void Pipeline::CompleteCreation(VulkanSystem& system)
+{
+	if (!stateKey.empty())
+		system.AddPipeline(stateKey, pipeline, pipelineLayout);
+	primaryPipeline = pipeline;
+	AddVariant(system, GetVariantKey(), pipeline);
+
+	system.DebugNameObject(pipeline, VK_OBJECT_TYPE_PIPELINE, "Pipeline", name);
 	auto inc = system.GetScopedDebugOutputIncrement();
-	system.DebugNameObject(pipelineLayout, VK_OBJECT_TYPE_PIPELINE_LAYOUT, "Pipeline Layout", debugName);
+	system.DebugNameObject(pipelineLayout, VK_OBJECT_TYPE_PIPELINE_LAYOUT, "Pipeline Layout", name);
+}
+
+void Pipeline::CreatePipelines(VulkanSystem& system, const std::vector<Pipeline*>& preparedPipelines)
+{
+	PROFILE_FUNCTION();
+	auto tStart = std::chrono::high_resolution_clock::now();
+
+	// Build in waves, derived pipelines wait until their parent has been created
+	std::vector<Pipeline*> remaining = preparedPipelines;
+	while (!remaining.empty())
+	{
+		std::vector<Pipeline*> wave, waiting;
+		for (auto pipeline : remaining)
+		{
+			if (pipeline->basePipeline != nullptr && !pipeline->basePipeline->Created())
+				waiting.push_back(pipeline);
+			else
+				wave.push_back(pipeline);
+		}
+		if (wave.empty())
+			throw std::runtime_error("Derived pipeline's parent is never created!");
+
+		size_t numThreads = std::min(wave.size(), (size_t)std::max(1u, std::thread::hardware_concurrency()));
+		std::atomic<size_t> nextPipeline(0);
+		std::vector<std::future<void>> workers;
+		for (size_t thread = 0; thread < numThreads; thread++)
+		{
+			workers.push_back(std::async(std::launch::async, [&system, &wave, &nextPipeline]()
+				{
+					CpuProfiler::ThreadScope threadScope("Pipeline Builder");
+					for (size_t index = nextPipeline++; index < wave.size(); index = nextPipeline++)
+						wave[index]->Build(system);
+				}));
+		}
+		for (auto& worker : workers)
+			worker.get();	// Rethrows any failure from the worker, Build throws if a pipeline can't be created
+
+		remaining.swap(waiting);
+	}
+
+	for (auto pipeline : preparedPipelines)
+		pipeline->CompleteCreation(system);
+
+	if (VulkanPlayground::showObjectCreationMessages)
+	{
+		auto tEnd = std::chrono::high_resolution_clock::now();
+		auto tDiff = std::chrono::duration<double, std::milli>(tEnd - tStart).count();
+		std::cout << "Created " << preparedPipelines.size() << " pipelines in " << tDiff << "ms\n";
+	}
+}
+
+std::string Pipeline::GetVariantKey(VkShaderStageFlagBits stage, const std::string* stageData) const
+{
+	StateKey key;
+	for (uint32_t stageNum = 0; stageNum < pipelineInfo.stageCount; stageNum++)
+	{
+		const auto& stageInfo = pipelineInfo.pStages[stageNum];
+		key.Add(stageInfo.stage);
+		if (stageInfo.stage == stage)
+			key.Add(*stageData);
+		else if (stageInfo.pSpecializationInfo != nullptr)
+			key.Add(std::string((const char*)stageInfo.pSpecializationInfo->pData, stageInfo.pSpecializationInfo->dataSize));
+	}
+	return key.Get();
+}
+
+VkPipeline Pipeline::BuildVariant(VulkanSystem& system, const VkGraphicsPipelineCreateInfo& createInfo, VkShaderStageFlagBits stage, const std::string* stageData)
+{	// Build a copy of the pipeline using different specialization data, can be called from a worker thread
+	std::vector<VkPipelineShaderStageCreateInfo> stages(createInfo.pStages, createInfo.pStages + createInfo.stageCount);
+	VkSpecializationInfo specializationInfo{};
+	for (auto& stageInfo : stages)
+	{
+		if (stageInfo.stage == stage)
+		{
+			specializationInfo = *stageInfo.pSpecializationInfo;
+			specializationInfo.pData = stageData->data();
+			stageInfo.pSpecializationInfo = &specializationInfo;
+		}
+	}
+
+	VkGraphicsPipelineCreateInfo variantInfo = createInfo;
+	variantInfo.pStages = stages.data();
+	variantInfo.basePipelineHandle = nullptr;
+	variantInfo.basePipelineIndex = -1;
+	variantInfo.flags &= ~VK_PIPELINE_CREATE_DERIVATIVE_BIT;
+
+	VkPipeline variant = nullptr;
+	CHECK_VULKAN(vkCreateGraphicsPipelines(system.GetDevice(), system.GetPipelineCache(), 1, &variantInfo, nullptr, &variant), "Failed to create graphics pipeline variant!");
+	return variant;
+}
+
+VkPipeline Pipeline::FindVariant(const std::string& key)
+{
+	std::lock_guard<std::mutex> lock(variantsMutex);
+	auto pos = variants.find(key);
+	return (pos != variants.end()) ? pos->second : nullptr;
+}
+
+void Pipeline::AddVariant(VulkanSystem& system, const std::string& key, VkPipeline variant)
+{
+	std::lock_guard<std::mutex> lock(variantsMutex);
+	auto pos = variants.find(key);
+	if (pos == variants.end())
+		variants[key] = variant;
+	else if (pos->second != variant)
+		vkDestroyPipeline(system.GetDevice(), variant, nullptr);	// Already built elsewhere
+}
+
+void Pipeline::PrewarmVariantData(VulkanSystem& system, VkShaderStageFlagBits stage, const std::vector<std::string>& variantData)
+{
+	if (pipelineLayout == nullptr)
+		throw std::runtime_error("Pipeline must be created before prewarming variants!");
+	auto specializationInfo = shader.FindShader(stage).pSpecializationInfo;
+	for (auto& data : variantData)
+	{
+		if (specializationInfo == nullptr || specializationInfo->dataSize != data.size())
+			throw std::runtime_error("Specialization variant doesn't match the shader's specialization data!");
+	}
+
+	if (prewarmTask.valid())
+		prewarmTask.get();
+
+	// The keys and the other stages' specialization data are taken now, the task only builds and adds the variants
+	std::vector<std::string> keys;
+	for (auto& data : variantData)
+		keys.push_back(GetVariantKey(stage, &data));
+	auto source = std::make_shared<VariantSource>();
+	source->pipelineInfo = pipelineInfo;
+	source->stages.assign(pipelineInfo.pStages, pipelineInfo.pStages + pipelineInfo.stageCount);
+	source->specializationInfos.resize(source->stages.size());
+	source->mapEntries.resize(source->stages.size());
+	source->specializationData.resize(source->stages.size());
+	for (size_t stageNum = 0; stageNum < source->stages.size(); stageNum++)
+	{
+		auto& stageInfo = source->stages[stageNum];
+		if (stageInfo.pSpecializationInfo == nullptr)
+			continue;
+		auto& specialization = *stageInfo.pSpecializationInfo;
+		source->mapEntries[stageNum].assign(specialization.pMapEntries, specialization.pMapEntries + specialization.mapEntryCount);
+		source->specializationData[stageNum].assign((const char*)specialization.pData, specialization.dataSize);
+		source->specializationInfos[stageNum] = specialization;
+		source->specializationInfos[stageNum].pMapEntries = source->mapEntries[stageNum].data();
+		source->specializationInfos[stageNum].pData = source->specializationData[stageNum].data();
+		stageInfo.pSpecializationInfo = &source->specializationInfos[stageNum];
+	}
+	source->pipelineInfo.pStages = source->stages.data();
+	source->pipelineInfo.layout = pipelineLayout;
+
+	prewarmTask = std::async(std::launch::async, [this, &system, stage, variantData, keys, source]()
+		{
+			for (size_t variant = 0; variant < variantData.size(); variant++)
+			{
+				if (FindVariant(keys[variant]) == nullptr)
+					AddVariant(system, keys[variant], BuildVariant(system, source->pipelineInfo, stage, &variantData[variant]));
+			}
+		});
 }
 
 void Pipeline::Bind(VkCommandBuffer commandBuffer, VkDescriptorSet descriptorSet, uint32_t dynamicOffset) const
 {
-	vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, pipeline);
+	BindState::CmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, pipeline);
 	if (descriptorSet != nullptr)
 	{
 		if (dynamicOffset != INVALID_VALUE)
-			vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, pipelineLayout, 0, 1, &descriptorSet, 1, &dynamicOffset);
+			BindState::CmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, pipelineLayout, 0, 1, &descriptorSet, 1, &dynamicOffset);
 		else
-			vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, pipelineLayout, 0, 1, &descriptorSet, 0, nullptr);
+			BindState::CmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, pipelineLayout, 0, 1, &descriptorSet, 0, nullptr);
 	}
 }
 
@@ -169,6 +472,23 @@ void Pipeline::Bind(VkCommandBuffer commandBuffer, const Descriptor& descriptor)
 	Bind(commandBuffer, descriptor.GetDescriptorSet());
 }
 
+void Pipeline::BindDescriptorSet(VkCommandBuffer commandBuffer, uint32_t set, VkDescriptorSet descriptorSet) const
+{
+	BindState::CmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, pipelineLayout, set, 1, &descriptorSet, 0, nullptr);
+}
+
+void Pipeline::PushDescriptorData(VkCommandBuffer commandBuffer, const Descriptor& descriptor, const void* data, size_t dataSize, uint32_t set) const
+{
+	if (cmdPushDescriptorSet == nullptr)
+		throw std::runtime_error("Push descriptors need VK_KHR_push_descriptor");
+
+	std::vector<VkWriteDescriptorSet> descriptorWrites;
+	descriptor.GetPushWrites(data, dataSize, descriptorWrites);
+	ApiCounters::RecordCommand(commandBuffer, ApiCall::PushDescriptorSet);
+	cmdPushDescriptorSet(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, pipelineLayout, set, (uint32_t)descriptorWrites.size(), descriptorWrites.data());
+	BindState::PushedDescriptorSet(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, set);
+}
+
 void Pipeline::SetupVertexDescription(const std::vector<Attribs::Attrib>& attribs)
 {
 	vertexDescription.attributeDescriptions.clear();
@@ -190,19 +510,40 @@ void Pipeline::SetupVertexDescription(const std::vector<Attribs::Attrib>& attrib
 	vertexDescription.bindingDescription.inputRate = VK_VERTEX_INPUT_RATE_VERTEX;
 }
 
-void Pipeline::Tidy(VulkanSystem& system)
+void Pipeline::Destroy(VulkanSystem& system)
 {
-	if (pipeline != nullptr)
+	if (prewarmTask.valid())
+		prewarmTask.get();
+	CancelReload(system);
+	for (auto& variant : variants)
+	{
+		if (variant.second != primaryPipeline)
+			vkDestroyPipeline(system.GetDevice(), variant.second, nullptr);
+	}
+	variants.clear();
+	if (primaryPipeline != nullptr)
+		pipeline = primaryPipeline;
+	primaryPipeline = nullptr;
+
+	if (pipeline != nullptr && system.ReleasePipeline(pipeline))
+		pipelineLayout = nullptr;	// Owned by the pipeline cache
+	else if (pipeline != nullptr)
 		vkDestroyPipeline(system.GetDevice(), pipeline, nullptr);
 	pipeline = nullptr;
 
 	if (pipelineLayout != nullptr)
 		vkDestroyPipelineLayout(system.GetDevice(), pipelineLayout, nullptr);
 	pipelineLayout = nullptr;
+}
+
+void Pipeline::Tidy(VulkanSystem& system)
+{
+	Destroy(system);
 
 	shader.Tidy(system);
 
 	dynamicStateEnables.clear();
+	extraDescriptorSetLayouts.clear();
 }
 
 void Pipeline::DerivePipeline(const Pipeline& parentPipeline)
@@ -212,6 +553,7 @@ void Pipeline::DerivePipeline(const Pipeline& parentPipeline)
 	SetPipelineFlags(VK_PIPELINE_CREATE_DERIVATIVE_BIT);
 	pipelineInfo.basePipelineHandle = parentPipeline.pipeline;
 	pipelineInfo.basePipelineIndex = -1;
+	basePipeline = &parentPipeline;
 }
 
 void Pipeline::EnableBlending(VkBlendFactor srcColorBlendFactor, VkBlendFactor dstColorBlendFactor, uint32_t numAttachements)
@@ -249,6 +591,7 @@ void Pipeline::EnableStencilTest(VkCompareOp compareOp, VkStencilOp Op, uint32_t
 Pipeline& Pipeline::operator=(const Pipeline& other)
 {
 	pipelineLayout = other.pipelineLayout;
+	cmdPushDescriptorSet = other.cmdPushDescriptorSet;
 
 	vertexDescription = other.vertexDescription;
 	dynamicStateEnables = other.dynamicStateEnables;
@@ -259,6 +602,7 @@ Pipeline& Pipeline::operator=(const Pipeline& other)
 	viewport = other.viewport;
 	scissor = other.scissor;
 	pushConstantRange = other.pushConstantRange;
+	extraDescriptorSetLayouts = other.extraDescriptorSetLayouts;
 	rasterizer = other.rasterizer;
 	multisampling = other.multisampling;
 	colorBlendAttachments = other.colorBlendAttachments;
@@ -271,8 +615,108 @@ Pipeline& Pipeline::operator=(const Pipeline& other)
 	return *this;
 }
 
+void Pipeline::ShaderModulesChanged(VulkanSystem& system, const std::map<std::string, VkShaderModule>& changedFiles)
+{
+	// Background builds read the shader stages, so let them finish first
+	if (prewarmTask.valid())
+		prewarmTask.wait();
+	if (reloadTask.valid())
+		reloadTask.wait();
+	if (!shader.ReplaceModules(changedFiles) || pipeline == nullptr)
+		return;	// Not using the changed shaders, or will pick them up when created
+
+	CancelReload(system);	// Changed again before the last rebuild was swapped in
+	reloadLayout = CreatePipelineLayout(system);
+
+	VkGraphicsPipelineCreateInfo reloadInfo = pipelineInfo;
+	reloadInfo.layout = reloadLayout;
+	reloadInfo.basePipelineHandle = nullptr;
+	reloadInfo.basePipelineIndex = -1;
+	reloadInfo.flags &= ~VK_PIPELINE_CREATE_DERIVATIVE_BIT;
+	reloadTask = std::async(std::launch::async, [&system, reloadInfo]()
+		{	// Stage data belongs to the shader, which isn't changed again until this completes
+			VkPipeline reloaded = nullptr;
+			CHECK_VULKAN_THROW(vkCreateGraphicsPipelines(system.GetDevice(), system.GetPipelineCache(), 1, &reloadInfo, nullptr, &reloaded), "Failed to create reloaded pipeline!");
+			return reloaded;
+		});
+}
+
+void Pipeline::CancelReload(VulkanSystem& system)
+{
+	if (!reloadTask.valid())
+		return;
+
+	try
+	{
+		VkPipeline reloaded = reloadTask.get();
+		vkDestroyPipeline(system.GetDevice(), reloaded, nullptr);
+	}
+	catch (std::runtime_error&)
+	{
+	}
+	vkDestroyPipelineLayout(system.GetDevice(), reloadLayout, nullptr);
+	reloadLayout = nullptr;
+}
+
+bool Pipeline::CheckReload(VulkanSystem& system)
+{
+	if (!reloadTask.valid() || reloadTask.wait_for(std::chrono::seconds(0)) != std::future_status::ready)
+		return false;
+
+	VkPipeline reloaded = nullptr;
+	try
+	{
+		reloaded = reloadTask.get();
+	}
+	catch (std::runtime_error& err)
+	{	// Keep the old pipeline running so the shader can be fixed
+		std::cout << "Failed to reload shaders for " << name << ": " << err.what() << "\n";
+		reloaded = nullptr;
+	}
+	if (reloaded == nullptr)
+	{
+		vkDestroyPipelineLayout(system.GetDevice(), reloadLayout, nullptr);
+		reloadLayout = nullptr;
+		return false;
+	}
+
+	system.DeviceWaitIdle();	// Ensure the old one is not in use
+	Destroy(system);
+	pipeline = reloaded;
+	pipelineLayout = reloadLayout;
+	pipelineInfo.layout = pipelineLayout;
+	reloadLayout = nullptr;
+	stateKey = StateKey();	// Not shared, the reloaded modules aren't known to other users
+	CompleteCreation(system);
+	return true;
+}
+
 bool Pipeline::CheckRecreate(VulkanSystem& system, RenderPass& renderPass)
 {
+	if (CheckReload(system))
+		return true;
+
+	if (specializationChanged && !recreate)
+	{
+		specializationChanged = false;
+
+		if (pipeline != nullptr)
+		{	// Nothing is destroyed, so no need to wait for the device
+			auto key = GetVariantKey();
+			VkPipeline variant = FindVariant(key);
+			if (variant == nullptr)
+			{
+				variant = BuildVariant(system, pipelineInfo);
+				AddVariant(system, key, variant);
+				variant = FindVariant(key);	// Might have been built by the prewarm in the meantime
+			}
+			bool changed = (variant != pipeline);
+			pipeline = variant;
+			return changed;
+		}
+	}
+	specializationChanged = false;
+
 	if (recreate)
 	{
 		recreate = false;
@@ -280,10 +724,7 @@ bool Pipeline::CheckRecreate(VulkanSystem& system, RenderPass& renderPass)
 		if (pipeline != nullptr)
 		{
 			system.DeviceWaitIdle();	// Ensure not in use
-			vkDestroyPipeline(system.GetDevice(), pipeline, nullptr);
-			pipeline = nullptr;
-			vkDestroyPipelineLayout(system.GetDevice(), pipelineLayout, nullptr);
-			pipelineLayout = nullptr;
+			Destroy(system);
 			Create(system, descriptorSetLayoutUsed, renderPass, "pipelineRecreated");
 			return true;
 		}
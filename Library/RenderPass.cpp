@@ -99,41 +99,7 @@ void RenderPass::Create(VulkanSystem &system, const std::string& debugName)
 		subPassDescs.push_back(subPassDesc);
 	}
 
-	std::vector<VkSubpassDependency> dependencies;
-
-	VkSubpassDependency dependency;
-	dependency.srcSubpass = VK_SUBPASS_EXTERNAL;
-	dependency.dstSubpass = 0;
-
-	dependency.srcStageMask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
-	dependency.dstStageMask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
-
-	dependency.srcAccessMask = 0;
-	dependency.dstAccessMask = VK_ACCESS_COLOR_ATTACHMENT_READ_BIT | VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT;
-
-	dependency.dependencyFlags = VK_DEPENDENCY_BY_REGION_BIT;
-
-	dependencies.push_back(dependency);
-
-	if (subpasses.size() > 1)
-	{
-		VkSubpassDependency subpassDependency;
-		subpassDependency.srcStageMask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
-		subpassDependency.dstStageMask = VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT;
-
-		subpassDependency.srcAccessMask = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT;
-		subpassDependency.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
-
-		subpassDependency.dependencyFlags = VK_DEPENDENCY_BY_REGION_BIT;
-
-		for (int i = 1; i < subpasses.size(); i++)
-		{
-			subpassDependency.srcSubpass = i - 1;
-			subpassDependency.dstSubpass = i;
-
-			dependencies.push_back(subpassDependency);
-		}
-	}
+	std::vector<VkSubpassDependency> dependencies = CreateDependencies();
 
 	VkRenderPassCreateInfo renderPassInfo{ VK_STRUCTURE_TYPE_RENDER_PASS_CREATE_INFO };
 	renderPassInfo.attachmentCount = (uint32_t)renderAttachments.size();
@@ -145,10 +111,129 @@ void RenderPass::Create(VulkanSystem &system, const std::string& debugName)
 	CHECK_VULKAN(vkCreateRenderPass(system.GetDevice(), &renderPassInfo, nullptr, &renderPass), "Failed to create render pass!");
 	system.DebugNameObject(renderPass, VK_OBJECT_TYPE_RENDER_PASS, "Renderpass", debugName);
 
+	// Pipelines can be used with any compatible renderpass, so just include the state that compatibility depends on (not load/store ops or layouts)
+	compatibilityKey = StateKey();
+	for (auto& attachment : renderAttachments)
+		compatibilityKey.Add(attachment.flags).Add(attachment.format).Add(attachment.samples);
+	for (auto& subPass : subpasses)
+	{
+		compatibilityKey.Add(subPass.colourAttachments.size()).Add(subPass.depthAttachments.size()).Add(subPass.inputs.size());
+		for (auto& ref : subPass.colourAttachments)
+			compatibilityKey.Add(ref.attachment);
+		for (auto& ref : subPass.depthAttachments)
+			compatibilityKey.Add(ref.attachment);
+		for (auto& ref : subPass.inputs)
+			compatibilityKey.Add(ref.attachment);
+	}
+	for (auto& dep : dependencies)
+		compatibilityKey.Add(dep);
+
 	imageAvailable.Create(system, "Image available");
 	renderFinished.Create(system, "Render finished");
 }
 
+std::vector<VkSubpassDependency> RenderPass::CreateDependencies() const
+{	// Work out the dependencies from how each subpass reads/writes the attachments, so only real hazards get synchronised
+	struct Access
+	{
+		VkPipelineStageFlags stage;
+		VkAccessFlags access;
+	};
+	const Access colourWrite{ VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT, VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT };
+	const Access colourReadWrite{ VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT, VK_ACCESS_COLOR_ATTACHMENT_READ_BIT | VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT };
+	const Access depthWrite{ VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT, VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT };
+	const Access depthReadWrite{ VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT | VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT, VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_READ_BIT | VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT };
+	const Access inputRead{ VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT, VK_ACCESS_INPUT_ATTACHMENT_READ_BIT };
+	const Access shaderRead{ VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT, VK_ACCESS_SHADER_READ_BIT };
+
+	std::map<std::pair<uint32_t, uint32_t>, VkSubpassDependency> dependencyMap;	// Merge all hazards between the same pair of subpasses
+	auto addDependency = [&dependencyMap](uint32_t srcSubpass, uint32_t dstSubpass, const Access& src, const Access& dst)
+	{
+		auto& dependency = dependencyMap[{ srcSubpass, dstSubpass }];
+		dependency.srcSubpass = srcSubpass;
+		dependency.dstSubpass = dstSubpass;
+		dependency.srcStageMask |= src.stage;
+		dependency.dstStageMask |= dst.stage;
+		dependency.srcAccessMask |= src.access;
+		dependency.dstAccessMask |= dst.access;
+		dependency.dependencyFlags = VK_DEPENDENCY_BY_REGION_BIT;
+	};
+
+	struct AttachmentState
+	{
+		bool used = false;
+		uint32_t lastWriter = VK_SUBPASS_EXTERNAL;
+		Access writeAccess{};
+		std::vector<uint32_t> readers;	// Since the last write
+	};
+	std::vector<AttachmentState> states(renderAttachments.size());
+	std::vector<bool> isDepth(renderAttachments.size(), false);	// From how the subpasses use it, the layouts can be anything
+	for (auto& subpass : subpasses)
+	{
+		for (auto& ref : subpass.depthAttachments)
+			isDepth[ref.attachment] = true;
+	}
+
+	auto firstUse = [&](uint32_t subpass, uint32_t attachment, const Access& dst)
+	{	// Previous work on the queue may still be writing to it (previous renderpass or frame)
+		auto& state = states[attachment];
+		if (!state.used)
+		{
+			addDependency(VK_SUBPASS_EXTERNAL, subpass, isDepth[attachment] ? depthWrite : colourWrite, dst);
+			state.used = true;
+			return true;
+		}
+		return false;
+	};
+	auto read = [&](uint32_t subpass, uint32_t attachment)
+	{
+		auto& state = states[attachment];
+		if (!firstUse(subpass, attachment, inputRead) && state.lastWriter != VK_SUBPASS_EXTERNAL && state.lastWriter != subpass)
+			addDependency(state.lastWriter, subpass, state.writeAccess, inputRead);
+		state.readers.push_back(subpass);
+	};
+	auto write = [&](uint32_t subpass, uint32_t attachment, const Access& src, const Access& dst)
+	{
+		auto& state = states[attachment];
+		if (!firstUse(subpass, attachment, dst))
+		{
+			if (state.lastWriter != VK_SUBPASS_EXTERNAL && state.lastWriter != subpass)
+				addDependency(state.lastWriter, subpass, state.writeAccess, dst);
+			for (auto reader : state.readers)
+			{	// Write after read only needs an execution dependency
+				if (reader != subpass)
+					addDependency(reader, subpass, { inputRead.stage, 0 }, { dst.stage, 0 });
+			}
+		}
+		state.lastWriter = subpass;
+		state.writeAccess = src;
+		state.readers.clear();
+	};
+
+	for (uint32_t subpass = 0; subpass < subpasses.size(); subpass++)
+	{
+		for (auto& ref : subpasses[subpass].inputs)
+			read(subpass, ref.attachment);
+		for (auto& ref : subpasses[subpass].colourAttachments)
+			write(subpass, ref.attachment, colourWrite, colourReadWrite);
+		for (auto& ref : subpasses[subpass].depthAttachments)
+			write(subpass, ref.attachment, depthWrite, depthReadWrite);
+	}
+
+	for (uint32_t attachment = 0; attachment < renderAttachments.size(); attachment++)
+	{	// Stored results that are going to be sampled after the renderpass (e.g. offscreen buffers)
+		auto& state = states[attachment];
+		const auto& description = renderAttachments[attachment];
+		if (state.lastWriter != VK_SUBPASS_EXTERNAL && description.storeOp == VK_ATTACHMENT_STORE_OP_STORE && description.finalLayout == VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL)
+			addDependency(state.lastWriter, VK_SUBPASS_EXTERNAL, state.writeAccess, shaderRead);
+	}
+
+	std::vector<VkSubpassDependency> dependencies;
+	for (auto& item : dependencyMap)
+		dependencies.push_back(item.second);
+	return dependencies;
+}
+
 void RenderPass::Tidy(VulkanSystem& system)
 {
 	displayBuffers.Tidy(system);
@@ -201,6 +286,13 @@ bool RenderPass::IsInputAttachment(uint32_t index) const
 	return false;
 }
 
+bool RenderPass::IsTransientAttachment(uint32_t index) const
+{	// Contents never leave the renderpass, so the image doesn't need backing in memory on tiled GPUs
+	const auto& attachment = renderAttachments[index];
+	return !IsSwapChainImage(index) && attachment.loadOp != VK_ATTACHMENT_LOAD_OP_LOAD && attachment.stencilLoadOp != VK_ATTACHMENT_LOAD_OP_LOAD &&
+		attachment.storeOp == VK_ATTACHMENT_STORE_OP_DONT_CARE && attachment.stencilStoreOp == VK_ATTACHMENT_STORE_OP_DONT_CARE;
+}
+
 VkFormat RenderPass::GetAttachmentFormat(uint32_t index) const
 {
 	return renderAttachments[index].format;
@@ -232,6 +324,34 @@ void RenderPass::SwitchOutputToAttachment()
 	}
 }
 
+VkSemaphore RenderPasses::SubmitCommandBuffers(uint32_t imageIndex, VkQueue queue, const std::vector<VkSemaphore>& waitSemaphores, const std::vector<VkPipelineStageFlags>& waitStages, VkFence fence, bool signalFinished)
+{
+	std::vector<VkCommandBuffer> commandBuffers;
+	for (auto renderPass : renderPasses)
+	{	// Passes without anything recorded are culled from the submission
+		VkCommandBuffer commandBuffer = renderPass->GetCommandBuffer(imageIndex);
+		if (commandBuffer != nullptr)
+		{
+			commandBuffers.push_back(commandBuffer);
+			ApiCounters::Submitted(renderPass->GetApiCalls(imageIndex));
+		}
+	}
+
+	VkSemaphore signalSemaphore = signalFinished ? renderPasses.back()->GetFinishedSemaphore() : VK_NULL_HANDLE;
+
+	VkSubmitInfo submitInfo{ VK_STRUCTURE_TYPE_SUBMIT_INFO };
+	submitInfo.waitSemaphoreCount = (uint32_t)waitSemaphores.size();
+	submitInfo.pWaitSemaphores = waitSemaphores.data();
+	submitInfo.pWaitDstStageMask = waitStages.data();
+	submitInfo.commandBufferCount = (uint32_t)commandBuffers.size();
+	submitInfo.pCommandBuffers = commandBuffers.data();
+	submitInfo.signalSemaphoreCount = signalFinished ? 1 : 0;
+	submitInfo.pSignalSemaphores = &signalSemaphore;
+	CHECK_VULKAN(vkQueueSubmit(queue, 1, &submitInfo, fence), "Failed to submit draw command");
+
+	return signalSemaphore;
+}
+
 RenderPass& RenderPasses::NewRenderPass()
 {
 	if (!renderPasses.empty())
@@ -4,16 +4,31 @@
 #include "System.h"
 #include "WinUtil.h"
 
-void Shader::Load(VulkanSystem& system, const std::string& vertexShader, const std::string& fragmentShader, const std::string& geometryShader)
+void Shader::Load(VulkanSystem& system, const std::string& vertexShader, const std::string& fragmentShader, const std::string& geometryShader, const std::vector<std::string>& defines)
 {
+	auto findModule = [&system, &defines](const std::string& shaderName, VkShaderModule& shaderModule, std::string& fileKey)
+	{
+		if (system.RuntimeShaderCompile() || !defines.empty())
+			return system.FindCompiledModule(shaderName, defines, shaderModule, &fileKey);
+		return system.FindModule(WinUtils::FindFile(shaderName + ".spv"), shaderModule, &fileKey);
+	};
+
 	vertexModule = nullptr, fragmentModule = nullptr, geometryModule = nullptr;
+	vertexFile.clear(), fragmentFile.clear(), geometryFile.clear();
 	bool existing = true;
 	if (!vertexShader.empty())
-		existing &= system.FindModule(WinUtils::FindFile(vertexShader + ".vert.spv"), vertexModule);
+		existing &= findModule(vertexShader + ".vert", vertexModule, vertexFile);
 	if (!fragmentShader.empty())
-		existing &= system.FindModule(WinUtils::FindFile(fragmentShader + ".frag.spv"), fragmentModule);
+		existing &= findModule(fragmentShader + ".frag", fragmentModule, fragmentFile);
 	if (!geometryShader.empty())
-		existing &= system.FindModule(WinUtils::FindFile(geometryShader + ".geom.spv"), geometryModule);
+		existing &= findModule(geometryShader + ".geom", geometryModule, geometryFile);
+
+	reflection = ShaderReflection();
+	for (auto shaderModule : { vertexModule, fragmentModule, geometryModule })
+	{
+		if (shaderModule)
+			reflection.Merge(system.GetModuleReflection(shaderModule));
+	}
 
 	if (vertexModule)
 	{
@@ -48,6 +63,26 @@ void Shader::Tidy(VulkanSystem& /*system*/)
 	shaderStages.clear();
 }
 
+bool Shader::ReplaceModules(const std::map<std::string, VkShaderModule>& changedFiles)
+{	// Used when shader files are reloaded, matched by file as other files may share the old module
+	bool changed = false;
+	std::pair<VkShaderModule*, const std::string*> modules[] = { { &vertexModule, &vertexFile }, { &fragmentModule, &fragmentFile }, { &geometryModule, &geometryFile } };
+	for (auto& module : modules)
+	{
+		auto pos = changedFiles.find(*module.second);
+		if (*module.first == nullptr || pos == changedFiles.end())
+			continue;
+		for (auto& stage : shaderStages)
+		{
+			if (stage.module == *module.first)
+				stage.module = pos->second;
+		}
+		*module.first = pos->second;
+		changed = true;
+	}
+	return changed;
+}
+
 SpecializationObject *Shader::GetSpecializationObject(VkShaderStageFlagBits shader)
 {
 	if (shader == VK_SHADER_STAGE_VERTEX_BIT)
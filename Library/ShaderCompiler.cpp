@@ -0,0 +1,162 @@
+#include "stdafx.h"
+#include "ShaderCompiler.h"
+#include "Common.h"
+#include "WinUtil.h"
+#include "CpuProfiler.h"
+
+#include <shaderc/shaderc.h>
+#include <filesystem>
+
+class ShadercDelayed : public WinUtils::DelayedLib
+{
+public:
+	ShadercDelayed() : WinUtils::DelayedLib("shaderc_shared.dll") {}
+
+	typedef shaderc_compiler_t(*shaderc_compiler_initializeFP)();
+	typedef void(*shaderc_compiler_releaseFP)(shaderc_compiler_t compiler);
+	typedef shaderc_compile_options_t(*shaderc_compile_options_initializeFP)();
+	typedef void(*shaderc_compile_options_add_macro_definitionFP)(shaderc_compile_options_t options, const char* name, size_t name_length, const char* value, size_t value_length);
+	typedef void(*shaderc_compile_options_releaseFP)(shaderc_compile_options_t options);
+	typedef shaderc_compilation_result_t(*shaderc_compile_into_spvFP)(const shaderc_compiler_t compiler, const char* source_text, size_t source_text_size, shaderc_shader_kind shader_kind, const char* input_file_name, const char* entry_point_name, const shaderc_compile_options_t additional_options);
+	typedef shaderc_compilation_status(*shaderc_result_get_compilation_statusFP)(const shaderc_compilation_result_t result);
+	typedef size_t(*shaderc_result_get_lengthFP)(const shaderc_compilation_result_t result);
+	typedef const char* (*shaderc_result_get_bytesFP)(const shaderc_compilation_result_t result);
+	typedef const char* (*shaderc_result_get_error_messageFP)(const shaderc_compilation_result_t result);
+	typedef void(*shaderc_result_releaseFP)(shaderc_compilation_result_t result);
+
+	shaderc_compiler_initializeFP shaderc_compiler_initialize = nullptr;
+	shaderc_compiler_releaseFP shaderc_compiler_release = nullptr;
+	shaderc_compile_options_initializeFP shaderc_compile_options_initialize = nullptr;
+	shaderc_compile_options_add_macro_definitionFP shaderc_compile_options_add_macro_definition = nullptr;
+	shaderc_compile_options_releaseFP shaderc_compile_options_release = nullptr;
+	shaderc_compile_into_spvFP shaderc_compile_into_spv = nullptr;
+	shaderc_result_get_compilation_statusFP shaderc_result_get_compilation_status = nullptr;
+	shaderc_result_get_lengthFP shaderc_result_get_length = nullptr;
+	shaderc_result_get_bytesFP shaderc_result_get_bytes = nullptr;
+	shaderc_result_get_error_messageFP shaderc_result_get_error_message = nullptr;
+	shaderc_result_releaseFP shaderc_result_release = nullptr;
+
+protected:
+	void Init() override
+	{
+		LoadFunction(shaderc_compiler_initialize, "shaderc_compiler_initialize");
+		LoadFunction(shaderc_compiler_release, "shaderc_compiler_release");
+		LoadFunction(shaderc_compile_options_initialize, "shaderc_compile_options_initialize");
+		LoadFunction(shaderc_compile_options_add_macro_definition, "shaderc_compile_options_add_macro_definition");
+		LoadFunction(shaderc_compile_options_release, "shaderc_compile_options_release");
+		LoadFunction(shaderc_compile_into_spv, "shaderc_compile_into_spv");
+		LoadFunction(shaderc_result_get_compilation_status, "shaderc_result_get_compilation_status");
+		LoadFunction(shaderc_result_get_length, "shaderc_result_get_length");
+		LoadFunction(shaderc_result_get_bytes, "shaderc_result_get_bytes");
+		LoadFunction(shaderc_result_get_error_message, "shaderc_result_get_error_message");
+		LoadFunction(shaderc_result_release, "shaderc_result_release");
+	}
+} shadercDelayed;
+
+std::string ShaderCompiler::FindSource(const std::string& shaderName)
+{
+	auto pos = sourceFiles.find(shaderName);
+	if (pos != sourceFiles.end())
+		return pos->second;
+
+	namespace fs = std::filesystem;
+	std::string sourceFile;
+	auto fileName = fs::path(shaderName).filename();
+	// Next to the .spv first, then the project's (or the library's) shader sources
+	fs::path spvFile = WinUtils::FindFile(shaderName + ".spv");
+	std::error_code error;
+	if (fs::exists(spvFile.parent_path() / fileName, error))
+		sourceFile = (spvFile.parent_path() / fileName).string();
+	else
+	{
+		std::vector<fs::path> dirs;
+		auto project = fs::path(shaderName).parent_path().relative_path();
+		if (!project.empty())
+			dirs.push_back(fs::path(VULKAN_PLAYGROUND_DIR) / "Examples" / project);
+		dirs.push_back(fs::path(VULKAN_PLAYGROUND_DIR) / "Library" / "shaders");
+		for (auto& dir : dirs)
+		{
+			for (fs::recursive_directory_iterator file(dir, error), end; !error && file != end; file.increment(error))
+			{
+				if (file->path().filename() == fileName)
+				{
+					sourceFile = file->path().string();
+					break;
+				}
+			}
+			if (!sourceFile.empty())
+				break;
+		}
+	}
+
+	sourceFiles[shaderName] = sourceFile;
+	return sourceFile;
+}
+
+std::string ShaderCompiler::GetCacheFile(const std::string& source, const std::string& sourceFile, const std::vector<std::string>& defines)
+{
+	StateKey key;
+	key.Add(source).Add(WinUtils::GetExtension(sourceFile));
+	for (auto& define : defines)
+		key.Add(define);
+	auto hash = VulkanPlayground::HashData(key.Get().data(), key.Get().size());
+
+	std::stringstream cacheFile;
+	cacheFile << VULKAN_PLAYGROUND_DIR << "\\bin\\ShaderCache\\" << std::filesystem::path(sourceFile).filename().string() << "." << std::hex << hash << ".spv";
+	return cacheFile.str();
+}
+
+void ShaderCompiler::Compile(const std::string& sourceFile, const std::vector<std::string>& defines, std::vector<char>& spirv)
+{
+	PROFILE_FUNCTION();
+	auto sourceCode = VulkanPlayground::ReadFile(sourceFile);
+	std::string source(sourceCode.begin(), sourceCode.end());
+	auto cacheFile = GetCacheFile(source, sourceFile, defines);
+	if (WinUtils::FileExists(cacheFile))
+	{
+		spirv = VulkanPlayground::ReadFile(cacheFile);
+		return;	// Warm, no need to load the compiler
+	}
+
+	static const std::map<std::string, shaderc_shader_kind> shaderKinds{ { "vert", shaderc_vertex_shader }, { "frag", shaderc_fragment_shader }, { "geom", shaderc_geometry_shader }, { "comp", shaderc_compute_shader } };
+	auto kind = shaderKinds.find(WinUtils::GetExtension(sourceFile));
+	if (kind == shaderKinds.end())
+		throw std::runtime_error("Unknown shader type: " + sourceFile);
+
+	shadercDelayed.Setup();
+	std::cout << "Compiling shader file: " << sourceFile << "\n";
+
+	auto compiler = shadercDelayed.shaderc_compiler_initialize();
+	auto options = shadercDelayed.shaderc_compile_options_initialize();
+	for (auto& define : defines)
+	{
+		auto equals = define.find('=');
+		auto value = (equals == std::string::npos) ? std::string() : define.substr(equals + 1);
+		auto name = define.substr(0, equals);
+		shadercDelayed.shaderc_compile_options_add_macro_definition(options, name.c_str(), name.size(), value.c_str(), value.size());
+	}
+
+	auto result = shadercDelayed.shaderc_compile_into_spv(compiler, source.c_str(), source.size(), kind->second, sourceFile.c_str(), "main", options);
+	bool compiled = (shadercDelayed.shaderc_result_get_compilation_status(result) == shaderc_compilation_status_success);
+	std::string errors = compiled ? "" : shadercDelayed.shaderc_result_get_error_message(result);
+	if (compiled)
+	{
+		auto bytes = shadercDelayed.shaderc_result_get_bytes(result);
+		spirv.assign(bytes, bytes + shadercDelayed.shaderc_result_get_length(result));
+	}
+	shadercDelayed.shaderc_result_release(result);
+	shadercDelayed.shaderc_compile_options_release(options);
+	shadercDelayed.shaderc_compiler_release(compiler);
+	if (!compiled)
+		throw std::runtime_error("Failed to compile shader: " + sourceFile + "\n" + errors);
+
+	// Write to a temporary and rename, so a partly written file is never picked up
+	std::error_code error;
+	std::filesystem::create_directories(std::filesystem::path(cacheFile).parent_path(), error);
+	std::string tempFile = cacheFile + ".tmp";
+	{
+		std::ofstream file(tempFile, std::ios::binary);
+		file.write(spirv.data(), spirv.size());
+	}
+	std::filesystem::rename(tempFile, cacheFile, error);
+}
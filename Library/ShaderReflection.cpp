@@ -0,0 +1,267 @@
+#include "stdafx.h"
+#include "ShaderReflection.h"
+#include "Common.h"
+
+// Just enough of a SPIR-V parser to find the resource variables and the types they use
+class SpirvParser
+{
+public:
+	enum Op : uint32_t {
+		OpEntryPoint = 15, OpTypeBool = 20, OpTypeInt = 21, OpTypeFloat = 22, OpTypeVector = 23, OpTypeMatrix = 24, OpTypeImage = 25, OpTypeSampler = 26,
+		OpTypeSampledImage = 27, OpTypeArray = 28, OpTypeRuntimeArray = 29, OpTypeStruct = 30, OpTypePointer = 32, OpConstant = 43,
+		OpSpecConstantTrue = 48, OpSpecConstantFalse = 49, OpSpecConstant = 50, OpVariable = 59, OpDecorate = 71, OpMemberDecorate = 72 };
+	enum Decoration : uint32_t { BufferBlock = 3, ArrayStride = 6, MatrixStride = 7, Binding = 33, DescriptorSet = 34, Offset = 35 };
+	enum StorageClass : uint32_t { UniformConstant = 0, Uniform = 2, PushConstant = 9, StorageBuffer = 12 };
+
+	struct Id
+	{
+		Id() : opcode(0), set(INVALID_VALUE), binding(INVALID_VALUE), arrayStride(0), bufferBlock(false)
+		{}
+		uint32_t opcode;
+		std::vector<uint32_t> words;	// Operands after the result id
+		uint32_t set, binding, arrayStride;
+		bool bufferBlock;
+		std::map<uint32_t, uint32_t> memberOffsets, memberMatrixStrides;
+	};
+
+	SpirvParser(const uint32_t* code, size_t numWords);
+	const Id& Get(uint32_t id) const;
+	uint32_t TypeSize(uint32_t typeId, uint32_t matrixStride = 0) const;
+	uint32_t ArrayLength(uint32_t lengthId) const;
+	VkDescriptorType GetDescriptorType(uint32_t typeId, uint32_t storageClass) const;
+
+	std::map<uint32_t, Id> ids;
+	std::vector<uint32_t> variables;
+	VkShaderStageFlags stage;
+};
+
+SpirvParser::SpirvParser(const uint32_t* code, size_t numWords) : stage(0)
+{
+	const uint32_t spirvMagic = 0x07230203;
+	if (numWords < 5 || code[0] != spirvMagic)
+		throw std::runtime_error("Not a SPIR-V module!");
+
+	for (size_t pos = 5; pos < numWords;)
+	{
+		uint32_t wordCount = code[pos] >> 16;
+		uint32_t opcode = code[pos] & 0xffff;
+		if (wordCount == 0 || pos + wordCount > numWords)
+			throw std::runtime_error("Corrupt SPIR-V module!");
+		const uint32_t* operands = code + pos + 1;
+		const uint32_t* operandsEnd = code + pos + wordCount;
+
+		switch (opcode)
+		{
+		case OpEntryPoint:
+		{
+			static const VkShaderStageFlagBits stages[] = { VK_SHADER_STAGE_VERTEX_BIT, VK_SHADER_STAGE_TESSELLATION_CONTROL_BIT, VK_SHADER_STAGE_TESSELLATION_EVALUATION_BIT,
+				VK_SHADER_STAGE_GEOMETRY_BIT, VK_SHADER_STAGE_FRAGMENT_BIT, VK_SHADER_STAGE_COMPUTE_BIT };
+			if (operands[0] < std::size(stages))
+				stage |= stages[operands[0]];
+			break;
+		}
+		case OpDecorate:
+		{
+			auto& id = ids[operands[0]];
+			if (operands[1] == DescriptorSet)
+				id.set = operands[2];
+			else if (operands[1] == Binding)
+				id.binding = operands[2];
+			else if (operands[1] == ArrayStride)
+				id.arrayStride = operands[2];
+			else if (operands[1] == BufferBlock)
+				id.bufferBlock = true;
+			break;
+		}
+		case OpMemberDecorate:
+			if (operands[2] == Offset)
+				ids[operands[0]].memberOffsets[operands[1]] = operands[3];
+			else if (operands[2] == MatrixStride)
+				ids[operands[0]].memberMatrixStrides[operands[1]] = operands[3];
+			break;
+		case OpTypeBool: case OpTypeInt: case OpTypeFloat: case OpTypeVector: case OpTypeMatrix: case OpTypeImage: case OpTypeSampler:
+		case OpTypeSampledImage: case OpTypeArray: case OpTypeRuntimeArray: case OpTypeStruct: case OpTypePointer:
+			ids[operands[0]].opcode = opcode;
+			ids[operands[0]].words.assign(operands + 1, operandsEnd);
+			break;
+		case OpSpecConstantTrue:
+		case OpSpecConstantFalse:
+			ids[operands[1]].opcode = opcode;
+			ids[operands[1]].words = { operands[0], opcode == OpSpecConstantTrue ? 1u : 0u };
+			break;
+		case OpConstant:	// Needed for array lengths
+		case OpSpecConstant:	// Lengths can also be specialization constants, their default value is used
+		case OpVariable:
+			ids[operands[1]].opcode = opcode;
+			ids[operands[1]].words.assign(operands + 2, operandsEnd);
+			ids[operands[1]].words.insert(ids[operands[1]].words.begin(), operands[0]);	// Result type first
+			if (opcode == OpVariable)
+				variables.push_back(operands[1]);
+			break;
+		}
+		pos += wordCount;
+	}
+}
+
+const SpirvParser::Id& SpirvParser::Get(uint32_t id) const
+{
+	auto pos = ids.find(id);
+	if (pos == ids.end())
+		throw std::runtime_error("Corrupt SPIR-V module, unknown id!");
+	return pos->second;
+}
+
+uint32_t SpirvParser::TypeSize(uint32_t typeId, uint32_t matrixStride) const
+{
+	auto& type = Get(typeId);
+	switch (type.opcode)
+	{
+	case OpTypeBool:
+		return 4;
+	case OpTypeInt:
+	case OpTypeFloat:
+		return type.words[0] / 8;
+	case OpTypeVector:
+		return TypeSize(type.words[0]) * type.words[1];
+	case OpTypeMatrix:
+		return (matrixStride != 0 ? matrixStride : TypeSize(type.words[0])) * type.words[1];
+	case OpTypeArray:
+	{
+		uint32_t length = ArrayLength(type.words[1]);
+		return (type.arrayStride != 0 ? type.arrayStride : TypeSize(type.words[0], matrixStride)) * length;
+	}
+	case OpTypeStruct:
+	{
+		uint32_t size = 0;
+		for (uint32_t member = 0; member < type.words.size(); member++)
+		{
+			auto offset = type.memberOffsets.find(member);
+			auto stride = type.memberMatrixStrides.find(member);
+			uint32_t memberSize = TypeSize(type.words[member], stride != type.memberMatrixStrides.end() ? stride->second : 0);
+			size = std::max(size, (offset != type.memberOffsets.end() ? offset->second : size) + memberSize);
+		}
+		return size;
+	}
+	default:
+		return 0;	// Runtime arrays etc.
+	}
+}
+
+uint32_t SpirvParser::ArrayLength(uint32_t lengthId) const
+{
+	auto& length = Get(lengthId);
+	if ((length.opcode != OpConstant && length.opcode != OpSpecConstant) || length.words.size() < 2)
+		throw std::runtime_error("Unsupported SPIR-V array length, it's not a constant!");	// e.g. calculated with OpSpecConstantOp
+	return length.words[1];
+}
+
+VkDescriptorType SpirvParser::GetDescriptorType(uint32_t typeId, uint32_t storageClass) const
+{
+	auto& type = Get(typeId);
+	switch (type.opcode)
+	{
+	case OpTypeSampler:
+		return VK_DESCRIPTOR_TYPE_SAMPLER;
+	case OpTypeSampledImage:
+		return VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+	case OpTypeImage:
+	{
+		const uint32_t dimBuffer = 5, dimSubpassData = 6, sampledStorage = 2;
+		uint32_t dim = type.words[1], sampled = type.words[5];
+		if (dim == dimSubpassData)
+			return VK_DESCRIPTOR_TYPE_INPUT_ATTACHMENT;
+		if (dim == dimBuffer)
+			return (sampled == sampledStorage) ? VK_DESCRIPTOR_TYPE_STORAGE_TEXEL_BUFFER : VK_DESCRIPTOR_TYPE_UNIFORM_TEXEL_BUFFER;
+		return (sampled == sampledStorage) ? VK_DESCRIPTOR_TYPE_STORAGE_IMAGE : VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE;
+	}
+	case OpTypeStruct:
+		return (storageClass == StorageBuffer || type.bufferBlock) ? VK_DESCRIPTOR_TYPE_STORAGE_BUFFER : VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
+	default:
+		throw std::runtime_error("Unsupported shader resource type!");
+	}
+}
+
+void ShaderReflection::Reflect(const std::vector<char>& spirv)
+{
+	sets.clear();
+	pushConstantRange = {};
+
+	SpirvParser parser((const uint32_t*)spirv.data(), spirv.size() / sizeof(uint32_t));
+	for (auto variableId : parser.variables)
+	{
+		auto& variable = parser.Get(variableId);
+		uint32_t storageClass = variable.words[1];
+		uint32_t typeId = parser.Get(variable.words[0]).words[1];	// Variables are pointers to the type
+
+		if (storageClass == SpirvParser::PushConstant)
+		{	// A stage may only use the end of the block (e.g. the fragment shader's part), so the range starts at its first member
+			auto& type = parser.Get(typeId);
+			uint32_t offset = type.memberOffsets.empty() ? 0 : INVALID_VALUE;
+			for (auto& memberOffset : type.memberOffsets)
+				offset = std::min(offset, memberOffset.second);
+			pushConstantRange.stageFlags = parser.stage;
+			pushConstantRange.offset = offset;
+			pushConstantRange.size = parser.TypeSize(typeId) - offset;
+			continue;
+		}
+		if ((storageClass != SpirvParser::UniformConstant && storageClass != SpirvParser::Uniform && storageClass != SpirvParser::StorageBuffer) ||
+			variable.set == INVALID_VALUE || variable.binding == INVALID_VALUE)
+			continue;
+
+		uint32_t count = 1;
+		for (auto* type = &parser.Get(typeId); type->opcode == SpirvParser::OpTypeArray || type->opcode == SpirvParser::OpTypeRuntimeArray; type = &parser.Get(typeId))
+		{
+			count = (type->opcode == SpirvParser::OpTypeArray) ? count * parser.ArrayLength(type->words[1]) : 0;
+			typeId = type->words[0];
+		}
+
+		VkDescriptorSetLayoutBinding binding{};
+		binding.binding = variable.binding;
+		binding.descriptorType = parser.GetDescriptorType(typeId, storageClass);
+		binding.descriptorCount = count;
+		binding.stageFlags = parser.stage;
+		sets[variable.set][variable.binding] = binding;
+	}
+}
+
+void ShaderReflection::Merge(const ShaderReflection& other)
+{
+	for (auto& set : other.sets)
+	{
+		for (auto& binding : set.second)
+		{
+			auto pos = sets[set.first].find(binding.first);
+			if (pos == sets[set.first].end())
+				sets[set.first][binding.first] = binding.second;
+			else if (pos->second.descriptorType != binding.second.descriptorType)
+				throw std::runtime_error("Shader stages use different descriptor types for the same binding!");
+			else
+			{
+				pos->second.stageFlags |= binding.second.stageFlags;
+				pos->second.descriptorCount = std::max(pos->second.descriptorCount, binding.second.descriptorCount);
+			}
+		}
+	}
+
+	if (other.pushConstantRange.size > 0)
+	{	// One range covering all the stages' parts
+		auto& range = other.pushConstantRange;
+		uint32_t start = (pushConstantRange.size > 0) ? std::min(pushConstantRange.offset, range.offset) : range.offset;
+		uint32_t end = std::max(pushConstantRange.offset + pushConstantRange.size, range.offset + range.size);
+		pushConstantRange.stageFlags |= range.stageFlags;
+		pushConstantRange.offset = start;
+		pushConstantRange.size = end - start;
+	}
+}
+
+std::vector<VkDescriptorSetLayoutBinding> ShaderReflection::GetBindings(uint32_t set) const
+{
+	std::vector<VkDescriptorSetLayoutBinding> bindings;
+	auto pos = sets.find(set);
+	if (pos != sets.end())
+	{
+		for (auto& binding : pos->second)
+			bindings.push_back(binding.second);
+	}
+	return bindings;
+}
@@ -3,9 +3,11 @@
 #include "RenderPass.h"
 #include "Image.h"
 #include "System.h"
+#include "CpuProfiler.h"
+#include "FrameCapture.h"
 
 SwapChain::SwapChain()
-	: swapChain(nullptr), workingExtent{}, imageCount(0)
+	: swapChain(nullptr), workingExtent{}, imageCount(0), nextHeadlessImage(0), lastHeadlessImage(INVALID_VALUE)
 {
 	swapChainImageFormat.format = VK_FORMAT_UNDEFINED;
 }
@@ -18,10 +20,26 @@ void SwapChain::Tidy(VulkanSystem& system)
 		vkDestroySwapchainKHR(system.GetDevice(), swapChain, nullptr);
 		swapChain = nullptr;
 	}
+	if (!headlessImages.empty())
+	{
+		system.DeviceWaitIdle();
+		for (auto& image : headlessImages)
+			image.DestroyBuffer(system);
+		headlessImages.clear();
+		for (auto fence : headlessFences)
+			vkDestroyFence(system.GetDevice(), fence, nullptr);
+		headlessFences.clear();
+	}
 }
 
 void SwapChain::Create(VulkanSystem &system, VkSurfaceKHR windowSurface, uint32_t width, uint32_t height, bool vSync, const std::string& debugName)
 {
+	if (windowSurface == nullptr)
+	{
+		CreateHeadless(system, width, height, debugName);
+		return;
+	}
+
 	swapChainDetails = GetSwapChainSupportDetails(system.GetPhysicalDevice(), windowSurface);
 
 	swapChainImageFormat = ChooseSwapSurfaceFormat(swapChainDetails.formats);
@@ -77,13 +95,45 @@ void SwapChain::Create(VulkanSystem &system, VkSurfaceKHR windowSurface, uint32_
 	system.DebugNameObject(presentQueue, VK_OBJECT_TYPE_QUEUE, "Queue", debugName);
 }
 
+void SwapChain::CreateHeadless(VulkanSystem& system, uint32_t width, uint32_t height, const std::string& debugName)
+{
+	swapChainImageFormat = { VK_FORMAT_B8G8R8A8_UNORM, VK_COLOR_SPACE_SRGB_NONLINEAR_KHR };	// Same as picked for a window
+	workingExtent = { width, height };
+	imageCount = std::max(1, VulkanPlayground::bufferCount);
+	nextHeadlessImage = 0;
+	lastHeadlessImage = INVALID_VALUE;
+
+	headlessImages.resize(imageCount);
+	for (auto& image : headlessImages)	// Can be copied from for checking the output
+		image.Create(system, swapChainImageFormat.format, VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | VK_IMAGE_USAGE_TRANSFER_SRC_BIT, width, height, 1, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, debugName + " Headless");
+
+	VkFenceCreateInfo fenceInfo{ VK_STRUCTURE_TYPE_FENCE_CREATE_INFO };
+	fenceInfo.flags = VK_FENCE_CREATE_SIGNALED_BIT;
+	headlessFences.resize(imageCount);
+	for (auto& fence : headlessFences)
+	{
+		CHECK_VULKAN_THROW(vkCreateFence(system.GetDevice(), &fenceInfo, nullptr, &fence), "Failed to create fence!");
+		system.DebugNameObject(fence, VK_OBJECT_TYPE_FENCE, "Fence", debugName + " Headless");
+	}
+
+	graphicsQueue = system.GetGraphicsQueuePool().GetQueue();
+}
+
 void SwapChain::CreateFrameBuffers(VulkanSystem &system, RenderPasses& renderPasses, VkFormat depthBufferFormat, const std::string& debugName)
 {
 	// Get the swap chain images (NB. may be more than we asked for (unlikely))
 	std::vector<VkImage> swapChainImages;
-	CHECK_VULKAN(vkGetSwapchainImagesKHR(system.GetDevice(), swapChain, &imageCount, nullptr), "Failed to get swapchain images");
-	swapChainImages.resize(imageCount);
-	CHECK_VULKAN(vkGetSwapchainImagesKHR(system.GetDevice(), swapChain, &imageCount, swapChainImages.data()), "Failed to get swapchain images");
+	if (Headless())
+	{
+		for (auto& image : headlessImages)
+			swapChainImages.push_back(image.GetImage());
+	}
+	else
+	{
+		CHECK_VULKAN(vkGetSwapchainImagesKHR(system.GetDevice(), swapChain, &imageCount, nullptr), "Failed to get swapchain images");
+		swapChainImages.resize(imageCount);
+		CHECK_VULKAN(vkGetSwapchainImagesKHR(system.GetDevice(), swapChain, &imageCount, swapChainImages.data()), "Failed to get swapchain images");
+	}
 
 	for (auto renderPass : renderPasses.GetRenderPasses())
 	{
@@ -135,16 +185,22 @@ SwapChainSupportDetails SwapChain::GetSwapChainSupportDetails(VkPhysicalDevice p
 
 bool SwapChain::DrawFrame(VulkanSystem& system, RenderPasses &renderPasses)
 {
+	PROFILE_FUNCTION();
 	system.DebugInsertLabel(system.GetGraphicsQueuePool().GetQueue(), "DrawFrame", { 1.0f, 0.0f, 0.0f });
+	system.GetGpuProfiler().CollectResults(system);
+	if (Headless())
+		return DrawHeadlessFrame(system, renderPasses);
 
 	VkSemaphore waitSemaphore = renderPasses.GetInitialWaitSemaphore();
 	std::vector<VkSemaphore> waitSemaphores{ waitSemaphore };
+	std::vector<VkPipelineStageFlags> waitStages{ VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT };
 
 	RenderPass* offscreenRenderPass = renderPasses.GetOffscreenRenderPass();
 	if (offscreenRenderPass)
 	{
 		auto extraWait = offscreenRenderPass->SubmitCommandBuffer(0, graphicsQueue, {});
 		waitSemaphores.push_back(extraWait);
+		waitStages.push_back(VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT);	// Offscreen buffer is sampled in the fragment shader
 	}
 
 	uint32_t imageIndex;
@@ -154,11 +210,7 @@ bool SwapChain::DrawFrame(VulkanSystem& system, RenderPasses &renderPasses)
 	if (!CHECK_VULKAN(result, "Failed to acquire swap chain image!"))
 		return false;
 
-	for (auto renderPass : renderPasses.GetRenderPasses())
-	{
-		waitSemaphore = renderPass->SubmitCommandBuffer(imageIndex, graphicsQueue, waitSemaphores);
-		waitSemaphores = { waitSemaphore };
-	}
+	waitSemaphore = renderPasses.SubmitCommandBuffers(imageIndex, graphicsQueue, waitSemaphores, waitStages);
 
 	VkPresentInfoKHR presentInfo{ VK_STRUCTURE_TYPE_PRESENT_INFO_KHR };
 	presentInfo.waitSemaphoreCount = 1;
@@ -174,6 +226,35 @@ bool SwapChain::DrawFrame(VulkanSystem& system, RenderPasses &renderPasses)
 	return true;
 }
 
+bool SwapChain::DrawHeadlessFrame(VulkanSystem& system, RenderPasses& renderPasses)
+{	// Round robin through the images, there's no acquire or present so no semaphores either side
+	uint32_t imageIndex = nextHeadlessImage;
+	nextHeadlessImage = (nextHeadlessImage + 1) % imageCount;
+	VkFence fence = headlessFences[imageIndex];
+	CHECK_VULKAN(vkWaitForFences(system.GetDevice(), 1, &fence, VK_TRUE, VulkanPlayground::NO_TIMEOUT), "Failed to wait for fence!");
+	CHECK_VULKAN(vkResetFences(system.GetDevice(), 1, &fence), "Failed to reset fence!");
+
+	std::vector<VkSemaphore> waitSemaphores;
+	std::vector<VkPipelineStageFlags> waitStages;
+	RenderPass* offscreenRenderPass = renderPasses.GetOffscreenRenderPass();
+	if (offscreenRenderPass)
+	{
+		waitSemaphores.push_back(offscreenRenderPass->SubmitCommandBuffer(0, graphicsQueue, {}));
+		waitStages.push_back(VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT);
+	}
+
+	renderPasses.SubmitCommandBuffers(imageIndex, graphicsQueue, waitSemaphores, waitStages, fence, false);
+	lastHeadlessImage = imageIndex;
+	return true;
+}
+
+void SwapChain::CaptureLastFrame(VulkanSystem& system, FrameCapture& capture)
+{
+	if (!Headless() || lastHeadlessImage == INVALID_VALUE)
+		throw std::runtime_error("No headless frame to capture");
+	capture.Capture(system, headlessImages[lastHeadlessImage].GetImage(), swapChainImageFormat.format, workingExtent.width, workingExtent.height, VK_IMAGE_LAYOUT_PRESENT_SRC_KHR);
+}
+
 VkSurfaceFormatKHR SwapChain::ChooseSwapSurfaceFormat(const std::vector<VkSurfaceFormatKHR>& availableFormats)
 {
 	if (availableFormats.size() == 1 && availableFormats.front().format == VK_FORMAT_UNDEFINED)
@@ -6,8 +6,11 @@
 #include "WinUtil.h"
 
 VulkanSystem::VulkanSystem()
-	: physicalDevice(nullptr), deviceProps(nullptr), deviceFeatures{}, queueIndicies{ }, device(nullptr), debugOutputIndent(0), requestedDeviceFeatures{}, fontsEnabled(true)
+	: physicalDevice(nullptr), deviceProps(nullptr), deviceFeatures{}, queueIndicies{ }, device(nullptr), pipelineCache(nullptr), debugOutputIndent(0), requestedDeviceFeatures{}, bindlessSupported(false), vkCmdPushDescriptorSetKHR(nullptr), vkCmdDrawIndexedIndirectCountKHR(nullptr), vkCreateDescriptorUpdateTemplateKHR(nullptr), vkDestroyDescriptorUpdateTemplateKHR(nullptr), vkUpdateDescriptorSetWithTemplateKHR(nullptr), shaderHotReload(false), runtimeShaderCompile(false), fontsEnabled(true), deviceMemory(0), peakDeviceMemory(0)
 {
+#if _DEBUG
+	shaderHotReload = true;	// Pick up shader edits without restarting
+#endif
 }
 
 VkFormat VulkanSystem::FindSupportedFormat(const std::vector<VkFormat>& candidates, VkImageTiling tiling, VkFormatFeatureFlags features)
@@ -54,17 +57,55 @@ void VulkanSystem::Setup(const Extensions& extensions, VulkanApplication &app)
 
 	if (device == nullptr)
 	{
-		device = VulkanPlayground::CreateLogicalDevice(physicalDevice, queueIndicies, extensions, requiredDeviceFeatures);
+		// Enable the descriptor indexing features needed for bindless textures when they're available
+		VkPhysicalDeviceDescriptorIndexingFeaturesEXT indexingFeatures{ VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_DESCRIPTOR_INDEXING_FEATURES_EXT };
+		bindlessSupported = false;
+		if (extensions.CheckIfDeviceExtensionEnabled(VK_EXT_DESCRIPTOR_INDEXING_EXTENSION_NAME))
+		{
+			VkPhysicalDeviceFeatures2 features{ VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2 };
+			features.pNext = &indexingFeatures;
+			vkGetPhysicalDeviceFeatures2(physicalDevice, &features);
+			bindlessSupported = indexingFeatures.shaderSampledImageArrayNonUniformIndexing && indexingFeatures.runtimeDescriptorArray &&
+				indexingFeatures.descriptorBindingPartiallyBound && indexingFeatures.descriptorBindingSampledImageUpdateAfterBind;
+
+			VkPhysicalDeviceDescriptorIndexingFeaturesEXT supported = indexingFeatures;
+			indexingFeatures = { VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_DESCRIPTOR_INDEXING_FEATURES_EXT };
+			indexingFeatures.shaderSampledImageArrayNonUniformIndexing = supported.shaderSampledImageArrayNonUniformIndexing;
+			indexingFeatures.runtimeDescriptorArray = supported.runtimeDescriptorArray;
+			indexingFeatures.descriptorBindingPartiallyBound = supported.descriptorBindingPartiallyBound;
+			indexingFeatures.descriptorBindingSampledImageUpdateAfterBind = supported.descriptorBindingSampledImageUpdateAfterBind;
+		}
+		device = VulkanPlayground::CreateLogicalDevice(physicalDevice, queueIndicies, extensions, requiredDeviceFeatures, bindlessSupported ? &indexingFeatures : nullptr);
 		requestedDeviceFeatures = requiredDeviceFeatures;
+		if (extensions.CheckIfDeviceExtensionEnabled(VK_KHR_PUSH_DESCRIPTOR_EXTENSION_NAME))
+			vkCmdPushDescriptorSetKHR = (PFN_vkCmdPushDescriptorSetKHR)vkGetDeviceProcAddr(device, "vkCmdPushDescriptorSetKHR");
+		if (extensions.CheckIfDeviceExtensionEnabled(VK_KHR_DRAW_INDIRECT_COUNT_EXTENSION_NAME))
+			vkCmdDrawIndexedIndirectCountKHR = (PFN_vkCmdDrawIndexedIndirectCountKHR)vkGetDeviceProcAddr(device, "vkCmdDrawIndexedIndirectCountKHR");
+		std::string updateTemplateSuffix = "-";	// Not available
+		if (GetDeviceProperties().apiVersion >= VK_API_VERSION_1_1)
+			updateTemplateSuffix = "";
+		else if (extensions.CheckIfDeviceExtensionEnabled(VK_KHR_DESCRIPTOR_UPDATE_TEMPLATE_EXTENSION_NAME))
+			updateTemplateSuffix = "KHR";
+		if (updateTemplateSuffix != "-")
+		{
+			vkCreateDescriptorUpdateTemplateKHR = (PFN_vkCreateDescriptorUpdateTemplateKHR)vkGetDeviceProcAddr(device, ("vkCreateDescriptorUpdateTemplate" + updateTemplateSuffix).c_str());
+			vkDestroyDescriptorUpdateTemplateKHR = (PFN_vkDestroyDescriptorUpdateTemplateKHR)vkGetDeviceProcAddr(device, ("vkDestroyDescriptorUpdateTemplate" + updateTemplateSuffix).c_str());
+			vkUpdateDescriptorSetWithTemplateKHR = (PFN_vkUpdateDescriptorSetWithTemplateKHR)vkGetDeviceProcAddr(device, ("vkUpdateDescriptorSetWithTemplate" + updateTemplateSuffix).c_str());
+		}
 		DebugNameObject(physicalDevice, VK_OBJECT_TYPE_PHYSICAL_DEVICE, "Physical Device", VulkanPlayground::GetDeviceDetailsName(physicalDevice));
 		auto incOutput = GetScopedDebugOutputIncrement();
 		DebugNameObject(device, VK_OBJECT_TYPE_DEVICE, "Logical Device", "");
 		auto incOutput2 = GetScopedDebugOutputIncrement();
 		bufMan.Setup(*this);
+
+		VkPipelineCacheCreateInfo pipelineCacheInfo{ VK_STRUCTURE_TYPE_PIPELINE_CACHE_CREATE_INFO };
+		CHECK_VULKAN(vkCreatePipelineCache(device, &pipelineCacheInfo, nullptr, &pipelineCache), "Failed to create pipeline cache!");
+		DebugNameObject(pipelineCache, VK_OBJECT_TYPE_PIPELINE_CACHE, "Pipeline Cache", "");
+		gpuProfiler.Create(*this);
 	}
 }
 
-uint32_t VulkanSystem::FindMemoryType(uint32_t typeFilter, VkMemoryPropertyFlags properties)
+bool VulkanSystem::FindMemoryType(uint32_t typeFilter, VkMemoryPropertyFlags properties, uint32_t& memoryType)
 {
 	VkPhysicalDeviceMemoryProperties memProperties;
 	vkGetPhysicalDeviceMemoryProperties(physicalDevice, &memProperties);
@@ -74,12 +115,21 @@ uint32_t VulkanSystem::FindMemoryType(uint32_t typeFilter, VkMemoryPropertyFlags
 		{
 			if ((memProperties.memoryTypes[i].propertyFlags & properties) == properties)
 			{
-				return i;
+				memoryType = i;
+				return true;
 			}
 		}
 	}
+	return false;
+}
+
+uint32_t VulkanSystem::FindMemoryType(uint32_t typeFilter, VkMemoryPropertyFlags properties)
+{
+	uint32_t memoryType;
+	if (!FindMemoryType(typeFilter, properties, memoryType))
+		throw std::runtime_error("Failed to find suitable memory!");
 
-	throw std::runtime_error("Failed to find suitable memory!");
+	return memoryType;
 }
 
 void VulkanSystem::DeviceWaitIdle()
@@ -93,28 +143,273 @@ void VulkanSystem::TidyUp()
 	if (device != nullptr)
 	{
 		for (auto shaderModule : shaderModules)
-			vkDestroyShaderModule(device, shaderModule.second, nullptr);
+			vkDestroyShaderModule(device, shaderModule.second.module, nullptr);
 		shaderModules.clear();
+		shaderFiles.clear();
+		moduleReflections.clear();
+
+		TidyPipelineCache();
+		bindlessTextures.Tidy(*this);
+		gpuProfiler.Tidy(*this);
+		for (auto& layout : descriptorSetLayouts)
+			vkDestroyDescriptorSetLayout(device, layout.second, nullptr);
+		descriptorSetLayouts.clear();
+		descriptorSetLayoutKeys.clear();
+		if (pipelineCache != nullptr)
+			vkDestroyPipelineCache(device, pipelineCache, nullptr);
+		pipelineCache = nullptr;
 
 		vkDestroyDevice(device, nullptr);
 		device = nullptr;
+		vkCmdPushDescriptorSetKHR = nullptr;
+		vkCmdDrawIndexedIndirectCountKHR = nullptr;
+		vkCreateDescriptorUpdateTemplateKHR = nullptr;
+		vkDestroyDescriptorUpdateTemplateKHR = nullptr;
+		vkUpdateDescriptorSetWithTemplateKHR = nullptr;
 	}
 }
 
-bool VulkanSystem::FindModule(const std::string& shaderFilename, VkShaderModule& shaderModule)
+bool VulkanSystem::FindModule(const std::string& shaderFilename, VkShaderModule& shaderModule, std::string* fileKey)
 {
-	auto pos = shaderModules.find(shaderFilename);
-	if (pos != shaderModules.end())
+	if (fileKey != nullptr)
+		*fileKey = shaderFilename;
+	auto pos = shaderFiles.find(shaderFilename);
+	if (pos != shaderFiles.end())
+	{
+		shaderModule = pos->second.module;
+		return true;
+	}
+
+	std::cout << "Loading shader file: " << shaderFilename << "\n";
+	std::error_code error;
+	auto writeTime = std::filesystem::last_write_time(shaderFilename, error);
+	auto shaderCode = VulkanPlayground::ReadFile(shaderFilename);
+	uint64_t hash = VulkanPlayground::HashData(shaderCode.data(), shaderCode.size());
+	bool existing;
+	shaderModule = GetModuleForCode(shaderCode, hash, WinUtils::GetJustFileName(shaderFilename), existing);
+	shaderFiles[shaderFilename] = ShaderFile{ hash, shaderModule, writeTime, shaderFilename, {}, false };
+	return existing;
+}
+
+bool VulkanSystem::FindCompiledModule(const std::string& shaderName, const std::vector<std::string>& defines, VkShaderModule& shaderModule, std::string* fileKey)
+{
+	auto sourceFile = shaderCompiler.FindSource(shaderName);
+	if (sourceFile.empty())
+	{
+		if (!defines.empty())
+			throw std::runtime_error("Failed to find shader source: " + shaderName);
+		return FindModule(WinUtils::FindFile(shaderName + ".spv"), shaderModule, fileKey);	// Only the prebuilt version is available
+	}
+
+	StateKey key;
+	key.Add(sourceFile);
+	for (auto& define : defines)
+		key.Add(define);
+	if (fileKey != nullptr)
+		*fileKey = key.Get();
+	auto pos = shaderFiles.find(key.Get());
+	if (pos != shaderFiles.end())
 	{
-		shaderModule = pos->second;
+		shaderModule = pos->second.module;
 		return true;
 	}
-	else
+
+	std::error_code error;
+	auto writeTime = std::filesystem::last_write_time(sourceFile, error);
+	std::vector<char> shaderCode;
+	shaderCompiler.Compile(sourceFile, defines, shaderCode);
+	uint64_t hash = VulkanPlayground::HashData(shaderCode.data(), shaderCode.size());
+	bool existing;
+	shaderModule = GetModuleForCode(shaderCode, hash, std::filesystem::path(sourceFile).filename().string(), existing);
+	shaderFiles[key.Get()] = ShaderFile{ hash, shaderModule, writeTime, sourceFile, defines, true };
+	return existing;
+}
+
+VkShaderModule VulkanSystem::GetModuleForCode(const std::vector<char>& shaderCode, uint64_t hash, const std::string& debugName, bool& existing)
+{
+	auto range = shaderModules.equal_range(hash);
+	for (auto pos = range.first; pos != range.second; ++pos)
 	{
-		shaderModule = VulkanPlayground::LoadShaderModule(*this, shaderFilename);
-		shaderModules[shaderFilename] = shaderModule;
+		if (pos->second.code == shaderCode)
+		{
+			existing = true;
+			return pos->second.module;
+		}
+	}
+
+	existing = false;
+	auto shaderModule = VulkanPlayground::CreateShaderModule(*this, shaderCode, debugName);
+	shaderModules.emplace(hash, SharedModule{ shaderModule, shaderCode });
+	try
+	{
+		moduleReflections[shaderModule].Reflect(shaderCode);
+	}
+	catch (std::runtime_error& err)
+	{	// Only needed by apps that use the reflected layouts
+		WinUtils::OutputWarning("Failed to reflect shader " + debugName + ": " + err.what());
+	}
+	return shaderModule;
+}
+
+const ShaderReflection& VulkanSystem::GetModuleReflection(VkShaderModule shaderModule) const
+{
+	static const ShaderReflection noReflection;
+	auto pos = moduleReflections.find(shaderModule);
+	return (pos != moduleReflections.end()) ? pos->second : noReflection;
+}
+
+bool VulkanSystem::CheckShaderChanges(std::map<std::string, VkShaderModule>& changedFiles)
+{
+	changedFiles.clear();
+	auto now = std::chrono::steady_clock::now();
+	if (!shaderHotReload || now - lastShaderCheck < std::chrono::milliseconds(500))
 		return false;
+	lastShaderCheck = now;
+
+	for (auto& file : shaderFiles)
+	{
+		std::error_code error;
+		auto writeTime = std::filesystem::last_write_time(file.second.path, error);
+		if (error || writeTime == file.second.writeTime)
+			continue;	// Unchanged, or mid save so try again later
+
+		std::vector<char> shaderCode;
+		try
+		{
+			if (file.second.compiled)
+				shaderCompiler.Compile(file.second.path, file.second.defines, shaderCode);
+			else
+				shaderCode = VulkanPlayground::ReadFile(file.second.path);
+		}
+		catch (std::runtime_error& err)
+		{
+			if (file.second.compiled)
+			{	// Report compile errors once, then wait for the next edit
+				WinUtils::OutputError(err.what());
+				file.second.writeTime = writeTime;
+			}
+			continue;
+		}
+		file.second.writeTime = writeTime;
+		uint64_t hash = VulkanPlayground::HashData(shaderCode.data(), shaderCode.size());
+		bool existing;
+		auto shaderModule = GetModuleForCode(shaderCode, hash, WinUtils::GetJustFileName(file.second.path), existing);
+		if (shaderModule == file.second.module)
+			continue;	// Touched but the same code
+
+		std::cout << "Reloading shader file: " << file.second.path << "\n";
+		changedFiles[file.first] = shaderModule;	// Only the pipelines that loaded this file change, not others sharing its old module
+		file.second.module = shaderModule;
+		file.second.hash = hash;
+	}
+	// Old modules are kept until TidyUp, other files may still share them
+	return !changedFiles.empty();
+}
+
+bool VulkanSystem::FindPipeline(const StateKey& key, VkPipeline& pipeline, VkPipelineLayout& pipelineLayout)
+{
+	auto pos = pipelines.find(key.Get());
+	if (pos == pipelines.end())
+		return false;
+
+	if (pos->second.refCount++ == 0)
+		unusedPipelines.remove(key.Get());
+	pipeline = pos->second.pipeline;
+	pipelineLayout = pos->second.pipelineLayout;
+	return true;
+}
+
+void VulkanSystem::AddPipeline(const StateKey& key, VkPipeline& pipeline, VkPipelineLayout& pipelineLayout)
+{
+	auto pos = pipelines.find(key.Get());
+	if (pos == pipelines.end())
+	{
+		pipelines[key.Get()] = CachedPipeline{ pipeline, pipelineLayout, 1 };
 	}
+	else if (pos->second.pipeline != pipeline)
+	{	// Same state was created more than once (e.g. built in parallel), so swap to the cached version
+		vkDestroyPipeline(device, pipeline, nullptr);
+		vkDestroyPipelineLayout(device, pipelineLayout, nullptr);
+		FindPipeline(key, pipeline, pipelineLayout);
+	}
+}
+
+bool VulkanSystem::ReleasePipeline(VkPipeline pipeline)
+{
+	auto pos = std::find_if(pipelines.begin(), pipelines.end(), [pipeline](const auto& cached) { return cached.second.pipeline == pipeline; });
+	if (pos == pipelines.end())
+		return false;
+
+	if (--pos->second.refCount == 0)
+	{
+		unusedPipelines.push_back(pos->first);
+		if (unusedPipelines.size() > maxUnusedPipelines)
+		{
+			auto oldest = pipelines.find(unusedPipelines.front());
+			vkDestroyPipeline(device, oldest->second.pipeline, nullptr);
+			vkDestroyPipelineLayout(device, oldest->second.pipelineLayout, nullptr);
+			pipelines.erase(oldest);
+			unusedPipelines.pop_front();
+		}
+	}
+	return true;
+}
+
+void VulkanSystem::TidyPipelineCache()
+{
+	for (auto& cached : pipelines)
+	{
+		vkDestroyPipeline(device, cached.second.pipeline, nullptr);
+		vkDestroyPipelineLayout(device, cached.second.pipelineLayout, nullptr);
+	}
+	pipelines.clear();
+	unusedPipelines.clear();
+}
+
+VkDescriptorSetLayout VulkanSystem::GetDescriptorSetLayout(const std::vector<VkDescriptorSetLayoutBinding>& bindings, const std::string& debugName, VkDescriptorSetLayoutCreateFlags flags)
+{
+	StateKey key;
+	key.Add(flags);
+	for (auto& binding : bindings)
+		key.Add(binding.binding).Add(binding.descriptorType).Add(binding.descriptorCount).Add(binding.stageFlags);
+
+	auto pos = descriptorSetLayouts.find(key.Get());
+	if (pos != descriptorSetLayouts.end())
+		return pos->second;
+
+	VkDescriptorSetLayoutCreateInfo descriptorSetLayoutInfo = { VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO };
+	descriptorSetLayoutInfo.flags = flags;
+	descriptorSetLayoutInfo.bindingCount = (uint32_t)bindings.size();
+	descriptorSetLayoutInfo.pBindings = bindings.data();
+
+	VkDescriptorSetLayout layout;
+	CHECK_VULKAN_THROW(vkCreateDescriptorSetLayout(device, &descriptorSetLayoutInfo, nullptr, &layout), "Failed to create descriptor set layout");
+	DebugNameObject(layout, VK_OBJECT_TYPE_DESCRIPTOR_SET_LAYOUT, "Descriptor Set Layout", debugName);
+
+	descriptorSetLayouts[key.Get()] = layout;
+	descriptorSetLayoutKeys[layout] = key;	// Lets pipelines using this layout be matched with ones using an identical layout
+	return layout;
+}
+
+BindlessTextures& VulkanSystem::GetBindlessTextures(uint32_t numTextures)
+{
+	if (bindlessTextures.Created() && bindlessTextures.GetCapacity() < numTextures)
+	{	// Made smaller by an earlier user, can only grow it once they've finished with it
+		if (bindlessTextures.GetNumRegistered() > 0)
+			throw std::runtime_error("Bindless texture table is in use, so can't be made bigger");
+		bindlessTextures.Tidy(*this);
+	}
+	if (!bindlessTextures.Created())
+		bindlessTextures.Create(*this, numTextures, "Bindless Textures");
+	if (bindlessTextures.GetCapacity() < numTextures)
+		throw std::runtime_error("Device can't have " + std::to_string(numTextures) + " bindless textures (limit " + std::to_string(bindlessTextures.GetCapacity()) + ")");
+	return bindlessTextures;
+}
+
+const StateKey* VulkanSystem::GetDescriptorSetLayoutKey(VkDescriptorSetLayout layout) const
+{
+	auto pos = descriptorSetLayoutKeys.find(layout);
+	return (pos != descriptorSetLayoutKeys.end()) ? &pos->second : nullptr;
 }
 
 void DebugMarker::Init(VkInstance instance)
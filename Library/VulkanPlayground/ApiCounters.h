@@ -0,0 +1,91 @@
+#pragma once
+
+#include <vulkan/vulkan.h>
+#include <array>
+#include <string>
+
+// Counts of Vulkan calls per frame, e.g. to see what state sorting and batching save, the same on any driver
+// Command buffers are recorded once and resubmitted, so the vkCmd* calls are counted into the command buffer's own counts
+// as it's recorded (see DisplayBuffers), then added to the frame each time it's submitted. Other calls are counted as they're made.
+// Binds of what's already bound and push constants that haven't changed are skipped by BindState, and counted as RedundantSkipped here
+// The calls are redirected by the macros at the bottom, which is opt-in: on in debug builds or when VULKAN_PLAYGROUND_API_COUNTERS
+// is defined, and VULKAN_PLAYGROUND_NO_API_COUNTERS turns it off in debug. Otherwise Vulkan is called directly and nothing's counted
+#if !defined(VULKAN_PLAYGROUND_API_COUNTERS) && defined(_DEBUG) && !defined(VULKAN_PLAYGROUND_NO_API_COUNTERS)
+#define VULKAN_PLAYGROUND_API_COUNTERS
+#endif
+
+enum class ApiCall
+{
+	BindPipeline, BindDescriptorSets, PushDescriptorSet, BindVertexBuffers, BindIndexBuffer, PushConstants,
+	Draw, DrawIndexed, DrawIndirect, DrawIndexedIndirect, Dispatch,
+	QueueSubmit, AllocateMemory, AllocateDescriptorSets, UpdateDescriptorSets,
+	RedundantSkipped,	// Binds and push constants that wouldn't have changed anything
+	NumCalls
+};
+
+struct ApiCallCounts
+{
+	std::array<uint32_t, (size_t)ApiCall::NumCalls> calls{};
+
+	uint32_t& operator[](ApiCall call) { return calls[(size_t)call]; }
+	uint32_t operator[](ApiCall call) const { return calls[(size_t)call]; }
+	ApiCallCounts& operator+=(const ApiCallCounts& other);
+	uint32_t GetDraws() const;	// All types
+	uint32_t GetBinds() const;	// Pipelines, descriptors and buffers
+	std::string GetSummary() const;	// Non-zero counts only
+
+	static const char* GetName(ApiCall call);
+};
+
+namespace ApiCounters
+{
+#ifdef VULKAN_PLAYGROUND_API_COUNTERS
+	void NextFrame();	// Call once a frame, after the frame's submits
+	ApiCallCounts GetLastFrame();
+	// The calls recorded into the command buffer on this thread are added to counts, until EndRecording
+	void BeginRecording(VkCommandBuffer commandBuffer, ApiCallCounts& counts);
+	void EndRecording();
+	void Submitted(const ApiCallCounts& counts);	// A command buffer's calls are part of this frame
+	void RecordCommand(VkCommandBuffer commandBuffer, ApiCall call);	// For calls that aren't wrapped (e.g. extension function pointers)
+
+	// Counted versions of the Vulkan calls
+	void CmdBindPipeline(VkCommandBuffer commandBuffer, VkPipelineBindPoint pipelineBindPoint, VkPipeline pipeline);
+	void CmdBindDescriptorSets(VkCommandBuffer commandBuffer, VkPipelineBindPoint pipelineBindPoint, VkPipelineLayout layout, uint32_t firstSet, uint32_t descriptorSetCount, const VkDescriptorSet* pDescriptorSets, uint32_t dynamicOffsetCount, const uint32_t* pDynamicOffsets);
+	void CmdBindVertexBuffers(VkCommandBuffer commandBuffer, uint32_t firstBinding, uint32_t bindingCount, const VkBuffer* pBuffers, const VkDeviceSize* pOffsets);
+	void CmdBindIndexBuffer(VkCommandBuffer commandBuffer, VkBuffer buffer, VkDeviceSize offset, VkIndexType indexType);
+	void CmdPushConstants(VkCommandBuffer commandBuffer, VkPipelineLayout layout, VkShaderStageFlags stageFlags, uint32_t offset, uint32_t size, const void* pValues);
+	void CmdDraw(VkCommandBuffer commandBuffer, uint32_t vertexCount, uint32_t instanceCount, uint32_t firstVertex, uint32_t firstInstance);
+	void CmdDrawIndexed(VkCommandBuffer commandBuffer, uint32_t indexCount, uint32_t instanceCount, uint32_t firstIndex, int32_t vertexOffset, uint32_t firstInstance);
+	void CmdDrawIndirect(VkCommandBuffer commandBuffer, VkBuffer buffer, VkDeviceSize offset, uint32_t drawCount, uint32_t stride);
+	void CmdDrawIndexedIndirect(VkCommandBuffer commandBuffer, VkBuffer buffer, VkDeviceSize offset, uint32_t drawCount, uint32_t stride);
+	void CmdDispatch(VkCommandBuffer commandBuffer, uint32_t groupCountX, uint32_t groupCountY, uint32_t groupCountZ);
+	VkResult QueueSubmit(VkQueue queue, uint32_t submitCount, const VkSubmitInfo* pSubmits, VkFence fence);
+	VkResult AllocateMemory(VkDevice device, const VkMemoryAllocateInfo* pAllocateInfo, const VkAllocationCallbacks* pAllocator, VkDeviceMemory* pMemory);
+	VkResult AllocateDescriptorSets(VkDevice device, const VkDescriptorSetAllocateInfo* pAllocateInfo, VkDescriptorSet* pDescriptorSets);
+	void UpdateDescriptorSets(VkDevice device, uint32_t descriptorWriteCount, const VkWriteDescriptorSet* pDescriptorWrites, uint32_t descriptorCopyCount, const VkCopyDescriptorSet* pDescriptorCopies);
+#else
+	inline void NextFrame() {}
+	inline ApiCallCounts GetLastFrame() { return ApiCallCounts(); }
+	inline void BeginRecording(VkCommandBuffer, ApiCallCounts&) {}
+	inline void EndRecording() {}
+	inline void Submitted(const ApiCallCounts&) {}
+	inline void RecordCommand(VkCommandBuffer, ApiCall) {}
+#endif
+}
+
+#ifdef VULKAN_PLAYGROUND_API_COUNTERS
+#define vkCmdBindPipeline(...) ApiCounters::CmdBindPipeline(__VA_ARGS__)
+#define vkCmdBindDescriptorSets(...) ApiCounters::CmdBindDescriptorSets(__VA_ARGS__)
+#define vkCmdBindVertexBuffers(...) ApiCounters::CmdBindVertexBuffers(__VA_ARGS__)
+#define vkCmdBindIndexBuffer(...) ApiCounters::CmdBindIndexBuffer(__VA_ARGS__)
+#define vkCmdPushConstants(...) ApiCounters::CmdPushConstants(__VA_ARGS__)
+#define vkCmdDraw(...) ApiCounters::CmdDraw(__VA_ARGS__)
+#define vkCmdDrawIndexed(...) ApiCounters::CmdDrawIndexed(__VA_ARGS__)
+#define vkCmdDrawIndirect(...) ApiCounters::CmdDrawIndirect(__VA_ARGS__)
+#define vkCmdDrawIndexedIndirect(...) ApiCounters::CmdDrawIndexedIndirect(__VA_ARGS__)
+#define vkCmdDispatch(...) ApiCounters::CmdDispatch(__VA_ARGS__)
+#define vkQueueSubmit(...) ApiCounters::QueueSubmit(__VA_ARGS__)
+#define vkAllocateMemory(...) ApiCounters::AllocateMemory(__VA_ARGS__)
+#define vkAllocateDescriptorSets(...) ApiCounters::AllocateDescriptorSets(__VA_ARGS__)
+#define vkUpdateDescriptorSets(...) ApiCounters::UpdateDescriptorSets(__VA_ARGS__)
+#endif
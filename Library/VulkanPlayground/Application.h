@@ -2,6 +2,7 @@
 
 #include "Camera.h"
 #include "UBO.h"
+#include "Descriptor.h"
 
 #if defined(COMBINED_EXAMPLES)
 #define DECLARE_APP(name) \
@@ -74,6 +75,10 @@ public:
 	void CreateDescriptor(VulkanSystem& system, Descriptor& descriptor, const std::string& debugDescriptorName);
 	void CreateBaseDescriptor(VulkanSystem& system, Descriptor& descriptor, const std::string& debugDescriptorName, uint32_t numDescriptors);
 	void CreateSharedDescriptor(const VulkanSystem& system, Descriptor& descriptor, VkDescriptorSetLayout otherDescriptorSetLayout, const std::string& debugName);
+	void CreatePushDescriptor(VulkanSystem& system, Descriptor& descriptor, const std::string& debugName);
+	// When deferred, CreatePipeline just queues pipelines which are then built together on worker threads before drawing
+	void DeferPipelineCreation(bool defer = true) { deferPipelineCreation = defer; }
+	void CreateDeferredPipelines(VulkanSystem& system);
 
 	unsigned int GetWindowWidth() const { return windowWidth; }
 	unsigned int GetWindowHeight() const { return windowHeight; }
@@ -96,6 +101,7 @@ public:
 	void CheckResetScene();
 
 	void GetWindowSize(GLFW& window);
+	void SetWindowSize(int width, int height) { windowWidth = width; windowHeight = height; }	// When headless
 
 	virtual void CreateCommandBuffers(VulkanSystem& system, RenderPasses& renderPasses);
 
@@ -122,16 +128,23 @@ public:
 	void SetTitle(const UnicodeString& name) { title = name; }
 	const UnicodeString& GetTitle() const { return title; }
 
+	// Frame times (.csv) and their statistics (.json) are written to this on exit, no extension
+	void SetFrameStatsFile(const std::string& filename) { frameStatsFile = filename; }
+	const std::string& GetFrameStatsFile() const { return frameStatsFile; }
+
 protected:
 	int windowWidth, windowHeight;
 	bool objectsCreated;
 	bool redrawScene;
 	bool resetScene;
 	bool showFPS;
+	bool showFrameStats;
 	bool vSync;
 	std::vector<Pipeline*> pipelines;
+	bool deferPipelineCreation;
+	std::vector<Pipeline*> deferredPipelines;
 	std::vector<Descriptor*> descriptors;
-	std::vector<VkDescriptorPool> descriptorPools;
+	DescriptorAllocator descriptorAllocator;
 	std::vector<ITidy*> tidyObjects;
 
 	glm::vec4 clearColour;
@@ -140,6 +153,7 @@ protected:
 	RenderPass* fontRenderPass;
 	std::unique_ptr<ITextHelper> textHelper;
 	UnicodeString title;
+	std::string frameStatsFile;
 };
 
 class VulkanApplication3D : virtual public VulkanApplication
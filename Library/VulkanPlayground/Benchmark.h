@@ -0,0 +1,34 @@
+#pragma once
+
+#include "WindowSystem.h"
+
+class VulkanApplication;
+
+// Runs apps headless and deterministically (fixed timestep and random seeds), a warm-up and then a measured number of frames, and writes their stats out as JSON
+class Benchmark
+{
+public:
+	Benchmark(int width, int height, uint32_t warmupFrames, uint32_t measuredFrames, float timestep = 1.0f / 60.0f);
+
+	bool Init(const std::string& name);
+	bool Run(const std::string& sceneName, VulkanApplication& app);	// False if the app failed
+	void Close();
+
+	bool WriteReport(const std::string& filename) const;
+	size_t GetNumFailed() const;
+
+private:
+	struct Result
+	{
+		std::string sceneName;
+		bool succeeded;
+		RunStats stats;
+	};
+
+	WindowSystem windowSystem;
+	std::string deviceName;
+	int width, height;
+	uint32_t warmupFrames, measuredFrames;
+	float timestep;
+	std::vector<Result> results;
+};
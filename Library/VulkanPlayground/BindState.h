@@ -0,0 +1,56 @@
+#pragma once
+
+// What's bound in a command buffer while it's recorded, so binds of what's already bound and push constants that haven't changed are skipped
+// One is held with each command buffer (see DisplayBuffers) and is current on the thread recording it. The Cmd* functions here are used by
+// the bind helpers (Pipeline::Bind, Model::Draw, Buffer::Bind etc.), so anything bound directly with Vulkan isn't tracked and mustn't be mixed with them
+// Fixed size so recording doesn't lock or allocate, binds beyond the sizes are just recorded (and forget what they replace)
+class BindState
+{
+public:
+	static bool filterRedundantState;	// Enabled by default, change it between recordings. Skips are counted as ApiCall::RedundantSkipped
+
+	void Begin(VkCommandBuffer commandBuffer);	// At the start of recording, nothing's bound
+	void End();
+
+	static void CmdBindPipeline(VkCommandBuffer commandBuffer, VkPipelineBindPoint pipelineBindPoint, VkPipeline pipeline);
+	static void CmdBindDescriptorSets(VkCommandBuffer commandBuffer, VkPipelineBindPoint pipelineBindPoint, VkPipelineLayout layout, uint32_t firstSet, uint32_t descriptorSetCount, const VkDescriptorSet* pDescriptorSets, uint32_t dynamicOffsetCount, const uint32_t* pDynamicOffsets);
+	static void CmdBindVertexBuffers(VkCommandBuffer commandBuffer, uint32_t firstBinding, uint32_t bindingCount, const VkBuffer* pBuffers, const VkDeviceSize* pOffsets);
+	static void CmdBindIndexBuffer(VkCommandBuffer commandBuffer, VkBuffer buffer, VkDeviceSize offset, VkIndexType indexType);
+	static void CmdPushConstants(VkCommandBuffer commandBuffer, VkPipelineLayout layout, VkShaderStageFlags stageFlags, uint32_t offset, uint32_t size, const void* pValues);
+	static void PushedDescriptorSet(VkCommandBuffer commandBuffer, VkPipelineBindPoint pipelineBindPoint, uint32_t set);	// After the push, it replaces the set
+
+private:
+	static const uint32_t maxSets = 8, maxDynamicOffsets = 4, maxVertexBindings = 8, maxPushConstantSize = 256;
+
+	static BindState* Get(VkCommandBuffer commandBuffer);	// nullptr when the command buffer isn't being recorded with one
+
+	struct BoundSet
+	{
+		VkDescriptorSet set = nullptr;	// nullptr when unknown
+		uint32_t numDynamicOffsets = 0;
+		uint32_t dynamicOffsets[maxDynamicOffsets] = {};
+	};
+	struct BindPoint
+	{
+		VkPipeline pipeline = nullptr;
+		VkPipelineLayout layout = nullptr;	// Of the bound descriptor sets
+		BoundSet sets[maxSets];
+	};
+	struct VertexBinding
+	{
+		VkBuffer buffer = nullptr;
+		VkDeviceSize offset = 0;
+	};
+	BindPoint& GetBindPoint(VkPipelineBindPoint pipelineBindPoint) { return bindPoints[pipelineBindPoint == VK_PIPELINE_BIND_POINT_COMPUTE ? 1 : 0]; }
+
+	VkCommandBuffer commandBuffer = nullptr;
+	BindPoint bindPoints[2];	// Graphics and compute
+	VertexBinding vertexBindings[maxVertexBindings];
+	VkBuffer indexBuffer = nullptr;
+	VkDeviceSize indexOffset = 0;
+	VkIndexType indexType = VK_INDEX_TYPE_UINT32;
+	VkPipelineLayout pushLayout = nullptr;	// Of the last push constants, nullptr when unknown
+	VkShaderStageFlags pushStages = 0;
+	uint32_t pushOffset = 0, pushSize = 0;
+	uint8_t pushData[maxPushConstantSize] = {};
+};
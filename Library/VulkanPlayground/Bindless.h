@@ -0,0 +1,38 @@
+#pragma once
+
+#include "Common.h"
+
+class VulkanSystem;
+class TextureBase;
+
+// Single global table of textures, indexed in shaders (e.g. from a push constant) rather than bound per material
+// Needs VK_EXT_descriptor_indexing, see VulkanSystem::BindlessSupported()
+class BindlessTextures : public ITidy
+{
+public:
+	BindlessTextures() : descriptorPool(nullptr), descriptorSetLayout(nullptr), descriptorSet(nullptr), capacity(0), nextIndex(0)
+	{}
+
+	// Never more than the device's update after bind limits, nor less than minTextures (so a few more can be registered later)
+	void Create(VulkanSystem& system, uint32_t maxTextures, const std::string& debugName);
+	bool Created() const { return descriptorSet != nullptr; }
+	void Tidy(VulkanSystem& system) override;
+
+	uint32_t Register(const VulkanSystem& system, const TextureBase& texture);
+	void Unregister(uint32_t index) { freeIndices.push_back(index); }	// Slot is just left unused (partially bound) until reused
+
+	VkDescriptorSetLayout GetDescriptorSetLayout() const { return descriptorSetLayout; }
+	VkDescriptorSet GetDescriptorSet() const { return descriptorSet; }
+	uint32_t GetCapacity() const { return capacity; }
+	uint32_t GetNumRegistered() const { return nextIndex - (uint32_t)freeIndices.size(); }
+
+	static const uint32_t minTextures = 64;
+
+private:
+	VkDescriptorPool descriptorPool;
+	VkDescriptorSetLayout descriptorSetLayout;
+	VkDescriptorSet descriptorSet;
+	uint32_t capacity;
+	uint32_t nextIndex;
+	std::vector<uint32_t> freeIndices;
+};
@@ -9,13 +9,13 @@ struct PixelData;
 class BufferBase
 {
 public:
-	BufferBase() : created(false), deviceMemory(nullptr)
+	BufferBase() : created(false), deviceMemory(nullptr), allocationSize(0)
 	{}
 	BufferBase(const BufferBase& other) = delete;
 	BufferBase& operator=(const BufferBase& other) = delete;
 
 	BufferBase(BufferBase&& other) noexcept
-		: created(other.created), deviceMemory(other.deviceMemory)
+		: created(other.created), deviceMemory(other.deviceMemory), allocationSize(other.allocationSize)
 	{
 		other.created = false;
 	}
@@ -23,6 +23,7 @@ public:
 	{
 		created = other.created;
 		deviceMemory = other.deviceMemory;
+		allocationSize = other.allocationSize;
 		other.created = false;
 		return *this;
 	}
@@ -37,6 +38,7 @@ protected:
 
 	bool created;
 	VkDeviceMemory deviceMemory;
+	VkDeviceSize allocationSize;
 };
 
 class Buffer : public BufferBase
@@ -123,14 +123,18 @@ namespace VulkanPlayground
 	// Helper functions to create Vulkan objects
 	VkInstance CreateInstance(const std::string& windowName, const Extensions& extensions);
 	VkPhysicalDevice FindPhysicalDevice(VkInstance instance, VkSurfaceKHR surface, QueueIndicies& queueIndicies, const Extensions& extensions);
-	VkDevice CreateLogicalDevice(VkPhysicalDevice physicalDevice, QueueIndicies queueIndicies, const Extensions& extensions, const VkPhysicalDeviceFeatures& deviceFeatures);
+	VkDevice CreateLogicalDevice(VkPhysicalDevice physicalDevice, QueueIndicies queueIndicies, const Extensions& extensions, const VkPhysicalDeviceFeatures& deviceFeatures, const void* featuresChain = nullptr);
 	VkImageView CreateImageView(const VulkanSystem& system, VkImage image, uint32_t mipLevels, VkFormat format, VkImageAspectFlags aspectFlags, const std::string& debugName, VkImageViewType viewType = VK_IMAGE_VIEW_TYPE_2D, uint32_t numImages = 1);
 	VkSampler CreateSampler(const VulkanSystem& system, uint32_t mipLevels, uint32_t maxAnisotropy, VkSamplerAddressMode addressMode, VkBorderColor borderColor, VkCompareOp compareOp, const std::string& debugName);
 	VkShaderModule LoadShaderModule(const VulkanSystem& system, const std::string& filename);
+	VkShaderModule CreateShaderModule(const VulkanSystem& system, const std::vector<char>& shaderCode, const std::string& debugName);
+	std::vector<char> ReadFile(const std::string& filename);
+	uint64_t HashData(const void* data, size_t size);	// FNV-1a, for content keyed caches
 
 	// Helper functions to enable features
 	void EnableFillModeNonSolid(const VkPhysicalDeviceFeatures& deviceFeatures, VkPhysicalDeviceFeatures* requiredFeatures);
 	void EnableWideLines(const VkPhysicalDeviceFeatures& deviceFeatures, VkPhysicalDeviceFeatures* requiredFeatures);
+	void EnableIndirectDrawing(const VkPhysicalDeviceFeatures& deviceFeatures, VkPhysicalDeviceFeatures* requiredFeatures);	// See IndirectDraw
 
 	std::string GetModelFile(const std::string& projectName, const std::string& modelFile);
 
@@ -160,10 +164,32 @@ namespace VulkanPlayground
 	extern const VkDeviceSize* zeroOffset;
 	extern const uint64_t NO_TIMEOUT;
 	extern int bufferCount;
+	extern uint32_t randomSeed;	// Fixed seed for the random number generators (e.g. for reproducible runs), 0 for a different seed each run
+	uint32_t RandomSeed();
 
 	inline void SetFloat4(float* dest, std::array<float, 4> src) { memcpy(dest, src.data(), sizeof(float) * 4); }
 }
 
+// Builds a binary key from object state, used to find matching objects in caches
+class StateKey
+{
+public:
+	template <class T> StateKey& Add(const T& value) { return AddData(&value, sizeof(value)); }
+	StateKey& AddData(const void* data, size_t size)
+	{
+		key.append((const char*)data, size);
+		return *this;
+	}
+	StateKey& Add(const std::string& value) { Add(value.size()); return AddData(value.data(), value.size()); }
+	StateKey& Add(const StateKey& other) { return Add(other.key); }
+
+	const std::string& Get() const { return key; }
+	bool empty() const { return key.empty(); }
+
+private:
+	std::string key;
+};
+
 class UnicodeString
 {
 public:
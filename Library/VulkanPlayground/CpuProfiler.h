@@ -0,0 +1,54 @@
+#pragma once
+
+#include <atomic>
+
+// Scoped CPU zones, e.g. PROFILE_ZONE("Load Model"), recorded while capturing and written out as Chrome trace JSON (chrome://tracing or ui.perfetto.dev)
+// Each thread records into its own fixed size buffer (allocated the first time it records in a capture), so there's no locking while recording
+// Define VULKAN_PLAYGROUND_NO_PROFILER to compile the zones out completely
+namespace CpuProfiler
+{
+	void StartCapture();
+	void StopCapture();
+	bool WriteChromeTrace(const std::string& filename);	// Of the last (or current) capture
+	void SetThreadName(const std::string& name);
+	void ReleaseThread();	// For short lived threads when they finish, their events are kept until the next capture
+
+	// Names a worker thread for its task, then releases its buffer
+	class ThreadScope
+	{
+	public:
+		ThreadScope(const std::string& name) { SetThreadName(name); }
+		~ThreadScope() { ReleaseThread(); }
+	};
+
+	int64_t Now();	// Nanoseconds
+	void Record(const char* name, int64_t start, int64_t end);
+
+	extern std::atomic<bool> capturing;
+	inline bool Capturing() { return capturing.load(std::memory_order_relaxed); }
+
+	class Zone
+	{
+	public:
+		Zone(const char* zoneName) : name(zoneName), start(Capturing() ? Now() : -1)
+		{}
+		~Zone()
+		{
+			if (start >= 0)
+				Record(name, start, Now());
+		}
+
+	private:
+		const char* name;	// Must outlive the capture, i.e. a string literal
+		int64_t start;
+	};
+}
+
+#ifdef VULKAN_PLAYGROUND_NO_PROFILER
+#define PROFILE_ZONE(name)
+#else
+#define PROFILE_CONCAT_INNER(a, b) a##b
+#define PROFILE_CONCAT(a, b) PROFILE_CONCAT_INNER(a, b)
+#define PROFILE_ZONE(name) CpuProfiler::Zone PROFILE_CONCAT(profileZone, __COUNTER__)(name)
+#endif
+#define PROFILE_FUNCTION() PROFILE_ZONE(__FUNCTION__)
@@ -9,8 +9,38 @@ class TextureBase;
 class BufferManager;
 class Image;
 class ImageWithView;
+class ShaderReflection;
 typedef std::vector<ImageWithView*> ImageWithViewList;
 
+// Allocates descriptor sets from a list of pools, adding bigger pools as they fill up. Sets are only freed in bulk by Reset
+class DescriptorAllocator : public ITidy
+{
+public:
+	explicit DescriptorAllocator(uint32_t initialSetsPerPool = 64) : currentPool(nullptr), setsPerPool(initialSetsPerPool), cacheSets(false)
+	{}
+
+	// The layout's bindings size a new pool if the sets don't fit in the existing ones, throws if they can't be allocated at all
+	void Allocate(const VulkanSystem& system, VkDescriptorSetLayout layout, const std::vector<VkDescriptorSetLayoutBinding>& bindings, uint32_t numSets, VkDescriptorSet* descriptorSets, const std::string& debugName);
+	// Optionally share sets between descriptors with the same layout and resources (they mustn't be updated after creation)
+	void CacheDescriptorSets(bool cache = true) { cacheSets = cache; }
+	bool CachingDescriptorSets() const { return cacheSets; }
+	bool FindDescriptorSet(const StateKey& key, VkDescriptorSet& descriptorSet) const;
+	void AddDescriptorSet(const StateKey& key, VkDescriptorSet descriptorSet) { cachedSets[key.Get()] = descriptorSet; }
+	void Reset(const VulkanSystem& system);	// Return all sets to the pools (dropping the cached ones), e.g. per frame or when the resources are recreated
+	void Tidy(VulkanSystem& system) override;
+
+private:
+	VkDescriptorPool NextPool(const VulkanSystem& system, const std::vector<VkDescriptorPoolSize>& required, uint32_t requiredSets, const std::string& debugName);
+
+	VkDescriptorPool currentPool;
+	std::vector<VkDescriptorPool> usedPools;
+	std::vector<VkDescriptorPool> freePools;
+	uint32_t setsPerPool;
+	static const uint32_t maxSetsPerPool = 4096;
+	bool cacheSets;
+	std::map<std::string, VkDescriptorSet> cachedSets;
+};
+
 class Descriptor : public ITidy
 {
 public:
@@ -24,19 +54,24 @@ public:
 	void Reset()
 	{
 		descriptorSetLayout = nullptr;
-		sharedDescriptorSetLayout = false;
 		pDynamicUniformBuffer = nullptr;
 		numDynBuffs = 0;
 		separateSampler = false;
 		uniformBuffers.clear();
+		storageBuffers.clear();
 		textures.clear();
 		bindings.clear();
 		attachmentImageViews.clear();
 		descriptorSets.clear();
+		updateTemplate = nullptr;
+		updateTemplateDataSize = 0;
 	}
 
-	void Create(const VulkanSystem& system, VkDescriptorPool descriptorPool, const std::string& debugDescriptorName, const std::string& debugDescriptorLayoutName = "");
-	void CreateShared(const VulkanSystem& system, VkDescriptorPool descriptorPool, VkDescriptorSetLayout otherDescriptorSetLayout, const std::string& debugName);
+	void Create(VulkanSystem& system, DescriptorAllocator& allocator, const std::string& debugDescriptorName, const std::string& debugDescriptorLayoutName = "");
+	void CreateShared(const VulkanSystem& system, DescriptorAllocator& allocator, VkDescriptorSetLayout otherDescriptorSetLayout, const std::string& debugName);
+	// No sets are allocated, the resources are pushed into the command buffer for each draw with Pipeline::PushDescriptor
+	void CreatePushDescriptor(VulkanSystem& system, const std::string& debugName);
+	void GetPushWrites(const void* data, size_t dataSize, std::vector<VkWriteDescriptorSet>& descriptorWrites) const;
 
 	void Tidy(VulkanSystem& system) override;
 
@@ -72,33 +107,53 @@ public:
 		uboLayoutBinding.stageFlags = stage;
 		bindings.push_back(uboLayoutBinding);
 	}
+	void AddStorageBuffer(uint32_t binding, Buffer& buffer, VkShaderStageFlags stage = VK_SHADER_STAGE_VERTEX_BIT);	// Created and tidied by the caller
 	void AddTexture(uint32_t binding, TextureBase& texture, VkShaderStageFlags stage = VK_SHADER_STAGE_FRAGMENT_BIT);
 	void AddTexture(VulkanSystem& system, uint32_t binding, Texture& texture, const std::string& filename, VkFormat format = VK_FORMAT_R8G8B8A8_UNORM, VkShaderStageFlags stage = VK_SHADER_STAGE_FRAGMENT_BIT);
 	void AddTextureArray(uint32_t binding, Texture* textureArray, uint32_t numTextures, VkShaderStageFlags stage = VK_SHADER_STAGE_FRAGMENT_BIT);
 	void AddTextureSampler(uint32_t binding, VkShaderStageFlags stage = VK_SHADER_STAGE_FRAGMENT_BIT);
 	void AddSubPassInput(uint32_t binding, const ImageWithViewList& image, VkShaderStageFlags stage = VK_SHADER_STAGE_FRAGMENT_BIT);
+	void AddBinding(uint32_t binding, VkDescriptorType type, VkShaderStageFlags stage, uint32_t count = 1);	// Resource supplied later, e.g. for push descriptors
+	// Reports (as warnings) bindings that don't match what the shaders use
+	bool CheckBindings(const ShaderReflection& reflection, const std::string& debugName, uint32_t set = 0) const;
 	uint32_t NumAttachmentImageViews() const { return (uint32_t)attachmentImageViews.size(); }
 
 	VkDescriptorSetLayout& GetDescriptorSetLayout() { return descriptorSetLayout; }
 	const VkDescriptorSet& GetDescriptorSet(uint32_t num = 0) const { return descriptorSets[num]; }
 
-	static VkDescriptorPool CreateDescriptorPool(const VulkanSystem& system, const std::vector<Descriptor*>& descriptors, uint32_t numDescriptors, const std::string& debugName);
+	// Update template (and push descriptor) data is packed in binding order, a VkDescriptorBufferInfo per buffer, a VkDescriptorImageInfo per image/sampler or a VkBufferView per texel buffer
+	void CreateUpdateTemplate(VulkanSystem& system, const std::string& debugName);
+	size_t GetUpdateTemplateDataSize() const { return updateTemplateDataSize; }
+	void UpdateSetFromData(const VulkanSystem& system, VkDescriptorSet descriptorSet, const void* data, size_t dataSize) const;
+	template <class T> void Update(const VulkanSystem& system, const T& data, uint32_t num = 0) const { UpdateSetFromData(system, descriptorSets[num], &data, sizeof(data)); }
+	// Per frame set from the allocator, written in one call
+	template <class T> VkDescriptorSet CreateTransientSet(const VulkanSystem& system, DescriptorAllocator& allocator, const T& data, const std::string& debugName) const
+	{
+		VkDescriptorSet descriptorSet;
+		allocator.Allocate(system, descriptorSetLayout, bindings, 1, &descriptorSet, debugName);
+		UpdateSetFromData(system, descriptorSet, &data, sizeof(data));
+		return descriptorSet;
+	}
 
 protected:
 	void AddTextureBinding(uint32_t binding, uint32_t numTextures, VkShaderStageFlags stage);
+	static size_t GetPackedInfoSize(VkDescriptorType type);
 
-	void CreateDescriptorSet(const VulkanSystem& system, VkDescriptorPool descriptorPool, uint32_t numDescriptors, const std::string& debugName);
+	void CreateDescriptorSet(const VulkanSystem& system, DescriptorAllocator& allocator, uint32_t numDescriptors, const std::string& debugName);
+	StateKey GetDescriptorSetKey(const std::vector<VkWriteDescriptorSet>& descriptorWrites) const;
 
 private:
 	Buffer* pDynamicUniformBuffer;
 	uint32_t numDynBuffs;
 	std::vector<Buffer*> uniformBuffers;
+	std::vector<Buffer*> storageBuffers;
 	std::map<uint32_t, const ImageWithViewList*> attachmentImageViews;
 	std::vector<TextureBase*> textures;
 	bool separateSampler;
 
 	VkDescriptorSetLayout descriptorSetLayout;
-	bool sharedDescriptorSetLayout;
+	VkDescriptorUpdateTemplate updateTemplate;
+	size_t updateTemplateDataSize;
 	std::vector<VkDescriptorSet> descriptorSets;
 	std::vector<VkDescriptorSetLayoutBinding> bindings;
 };
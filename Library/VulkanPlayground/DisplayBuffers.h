@@ -10,6 +10,7 @@ class ImageWithView;
 
 #include "Image.h"
 #include "Common.h"
+#include "BindState.h"
 
 class Semaphore : public ITidy
 {
@@ -31,6 +32,8 @@ class DisplayBuffers : public ITidy
 		VkCommandBuffer commandBuffer = nullptr;
 		VkFramebuffer frameBuffer = nullptr;
 		VkImageView swapChainImageView = nullptr;	// Remember so can be cleaned up later
+		ApiCallCounts apiCalls;	// Recorded into the command buffer, added to the frame when it's submitted
+		BindState bindState;	// Only while recording
 	};
 
 public:
@@ -41,6 +44,9 @@ public:
 	void CreateCmdBuffers(VulkanSystem& system, RenderPass& renderPass, std::function<void(VkCommandBuffer)> DrawFun, const std::string& debugName);
 	void SubmitCommandBuffer(uint32_t buffNum, VkQueue queue, const std::vector<VkSemaphore>& waitSemaphores, const std::vector<VkSemaphore>& signalSemaphores, VkPipelineStageFlags waitStage = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT);
 
+	VkCommandBuffer GetCommandBuffer(uint32_t buffNum) const { return (buffNum < buffers.size()) ? buffers[buffNum].commandBuffer : nullptr; }	// nullptr when nothing's recorded
+	const ApiCallCounts& GetApiCalls(uint32_t buffNum) const;	// None when nothing's recorded
+
 	void FreeCmdBuffers(VulkanSystem& system);
 	void Tidy(VulkanSystem& system) override;
 
@@ -0,0 +1,42 @@
+#pragma once
+
+#include "Common.h"
+
+class Pipeline;
+class Model;
+
+struct DrawPacket
+{
+	Pipeline* pipeline;
+	VkDescriptorSet descriptorSet;
+	uint32_t dynamicOffset;	// INVALID_VALUE for none
+	Model* model;
+	uint32_t instanceCount;
+	std::vector<uint8_t> pushConstants;	// Empty for none, otherwise the pipeline's push constant size
+	float depth;	// e.g. view space distance, only used for ordering
+	bool transparent;
+};
+
+// Draws are added in any order then sorted on a 64 bit key before being recorded, to cut down on state changes
+// Opaque draws go first, grouped by pipeline, descriptor set and model then front to back (for early depth rejection)
+// Transparent draws go last, back to front so they blend correctly
+// Sorting happens when the command buffer is recorded, so depth ordering is only as recent as the last RedrawScene
+class DrawList
+{
+public:
+	void Clear() { packets.clear(); }
+	void Add(DrawPacket packet);	// Throws if the push constants aren't the pipeline's size
+	void AddDraw(Pipeline& pipeline, VkDescriptorSet descriptorSet, Model& model, float depth = 0.0f, bool transparent = false, uint32_t dynamicOffset = INVALID_VALUE);
+	template <class T> void AddDrawWithPushConstants(Pipeline& pipeline, VkDescriptorSet descriptorSet, Model& model, const T& pushConstants, float depth = 0.0f, bool transparent = false)
+		{ AddDrawWithPushConstantData(pipeline, descriptorSet, model, &pushConstants, sizeof(T), depth, transparent); }
+	void AddDrawWithPushConstantData(Pipeline& pipeline, VkDescriptorSet descriptorSet, Model& model, const void* data, size_t dataSize, float depth = 0.0f, bool transparent = false);
+
+	void Record(VkCommandBuffer commandBuffer);	// Sorts then records, only binding what changes
+	size_t GetNumDraws() const { return packets.size(); }
+
+private:
+	void Sort();
+
+	std::vector<DrawPacket> packets;
+	std::vector<std::pair<uint64_t, uint32_t>> sortKeys;	// Key and packet index, kept to save reallocating
+};
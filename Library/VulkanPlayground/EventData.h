@@ -1,5 +1,8 @@
 #pragma once
 
+#include <fstream>
+#include <string>
+
 enum class MouseButton { None, Left, Right };
 
 struct MouseData
@@ -17,7 +20,7 @@ class EventData
 	enum KEY_STATE { KEY_DOWN = 1, KEY_UP = 0, KEY_PRESS = 2  };
 
 public:
-	EventData() : keys{  }, newKeyPress(false), shifted(false), firstMouse(true), lastX(0), lastY(0) {}
+	EventData() : keys{  }, newKeyPress(false), shifted(false), firstMouse(true), lastX(0), lastY(0), frame(0), replayEvent{}, replayingEvent(false) {}
 
 	bool KeyPressed(int key) const;
 	bool KeyDown(int key) const;
@@ -28,11 +31,22 @@ public:
 
 	void MouseMoved(float xpos, float ypos);
 	void MousePress(int button, bool press);
-	void MouseScroll(float yoffset) { mouseData.scroll = yoffset; }
+	void MouseScroll(float yoffset);
 
 	bool GetMouseData(MouseData& mouseData);
+
+	// Input is recorded against the frame number, so replaying with a fixed timestep repeats the run exactly
+	bool StartRecording(const std::string& filename);
+	void StopRecording() { recordFile.close(); }
+	bool StartReplay(const std::string& filename);	// Live input is ignored until the replay finishes
+	bool Replaying() const { return replayFile.is_open(); }
+	void NextFrame();	// Once a frame, before the input is read
 		
 private:
+	bool Ignore() const { return replayFile.is_open() && !replayingEvent; }
+	void RecordEvent(char type, float x, float y);
+	bool ReadReplayEvent();
+
 	mutable KEY_STATE keys[1024];
 	bool newKeyPress;
 	bool shifted;
@@ -41,4 +55,16 @@ private:
 	float lastX, lastY;
 
 	MouseData mouseData;
+
+	struct RecordedEvent
+	{
+		uint32_t frame;
+		char type;	// K(ey), M(ove), B(utton) or S(croll)
+		float x, y;
+	};
+	uint32_t frame;
+	std::ofstream recordFile;
+	std::ifstream replayFile;
+	RecordedEvent replayEvent;	// Next one to replay
+	bool replayingEvent;
 };
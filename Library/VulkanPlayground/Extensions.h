@@ -19,6 +19,8 @@ public:
 	void AddValidationLayer(const char* layer) { validationLayers.push_back(layer); }
 	void AddReqExtension(const char* extension) { reqExtensions.push_back(extension); }
 	void AddReqDeviceExtension(const char* extension) { reqDeviceExtensions.push_back(extension); }
+	void AddOptionalDeviceExtension(const char* extension) { optionalDeviceExtensions.push_back(extension); }
+	void EnableOptionalDeviceExtensions(VkPhysicalDevice physicalDevice);	// Adds the ones the selected device supports
 
 	bool CheckIfInstanceExtensionEnabled(const char* extension) const;
 	bool CheckIfDeviceExtensionEnabled(const char* extension) const;
@@ -36,6 +38,7 @@ private:
 	std::vector<const char*> validationLayers;
 	std::vector<const char*> reqExtensions;
 	std::vector<const char*> reqDeviceExtensions;
+	std::vector<const char*> optionalDeviceExtensions;
 
 	DebugCallback debugCallback;
 };
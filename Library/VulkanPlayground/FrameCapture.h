@@ -0,0 +1,52 @@
+#pragma once
+
+#include "Common.h"
+#include "Buffers.h"
+
+// How far a rendered image is from a reference (golden) one, channel differences are 0-255
+struct ImageComparison
+{
+	bool sizeMatches;
+	uint64_t numPixels;
+	uint64_t differentPixels;	// Any channel further out than the tolerance
+	uint32_t maxDifference;
+	double rmse;	// Root mean square over all channels
+	double psnr;	// dB, infinite when identical
+
+	bool Passed(double allowedFraction = 0.0) const;	// Of pixels allowed to differ
+	std::string GetSummary() const;
+};
+
+// Copies a rendered image back to host memory so it can be saved as a PNG or compared against a golden image
+// The copy is queued after the frame without waiting for it, the pixels are picked up later (or waited for)
+class FrameCapture : public ITidy
+{
+public:
+	FrameCapture() : commandBuffer(nullptr), fence(nullptr), mappedPixels(nullptr), width(0), height(0), swizzle(false)
+	{}
+
+	// The image needs TRANSFER_SRC usage, it's left in the layout it was in
+	void Capture(VulkanSystem& system, VkImage image, VkFormat format, uint32_t width, uint32_t height, VkImageLayout layout);
+	bool Pending() const { return fence != nullptr; }
+	bool Ready(VulkanSystem& system);	// Doesn't wait
+	bool GetPixels(VulkanSystem& system, std::vector<uint8_t>& rgba);	// Waits for the copy, false if nothing was captured
+	bool SavePng(VulkanSystem& system, const std::string& filename);
+	ImageComparison Compare(VulkanSystem& system, const std::string& goldenFile, uint32_t tolerance = 2);
+
+	uint32_t GetWidth() const { return width; }
+	uint32_t GetHeight() const { return height; }
+	void Tidy(VulkanSystem& system) override;
+
+	static bool WritePng(const std::string& filename, uint32_t width, uint32_t height, const uint8_t* rgba);
+	static ImageComparison CompareImages(const uint8_t* rgba, uint32_t width, uint32_t height, const uint8_t* goldenRgba, uint32_t goldenWidth, uint32_t goldenHeight, uint32_t tolerance);
+
+private:
+	void FinishCopy(VulkanSystem& system);
+
+	Buffer readback;
+	VkCommandBuffer commandBuffer;
+	VkFence fence;
+	void* mappedPixels;
+	uint32_t width, height;
+	bool swizzle;	// BGRA images
+};
@@ -3,17 +3,40 @@
 #include <chrono>
 #include <iomanip>
 #include <sstream>
+#include <fstream>
+#include <vector>
+#include <algorithm>
+
+// Frame times (in ms) over the last FPSTimer::historySize frames
+struct FrameStats
+{
+	size_t numFrames;
+	float average, p50, p95, p99, max;
+	size_t stutters;	// Frames taking more than twice the recent average, since the start or last reset
+};
 
 class FPSTimer
 {
 public:
+	static const size_t historySize = 1024;
+
 	FPSTimer()
 	{
 		detailed = false;
 		lastFrameTime = 0;
+		fixedTimestep = 0;
 		ResetTotals();
 		frame_start = std::chrono::high_resolution_clock::now();
 		dataLine = "fps:";
+		history.resize(historySize);
+		ResetHistory();
+	}
+	void ResetHistory()
+	{
+		historyPos = 0;
+		historyCount = 0;
+		historyTotal = 0;
+		stutters = 0;
 	}
 	void ResetTotals()
 	{
@@ -30,11 +53,12 @@ public:
 
 		if (lastFrameTime > frame_max)
 			frame_max = lastFrameTime;
-		else if (frame_min == 0 || lastFrameTime < frame_min)
+		if (frame_min == 0 || lastFrameTime < frame_min)
 			frame_min = lastFrameTime;
 		frame_total += lastFrameTime;
 
 		numFrames++;
+		AddToHistory(lastFrameTime * 1000.0f);
 
 		if (frame_total > 1)
 		{
@@ -51,17 +75,108 @@ public:
 
 		frame_start = frame_end;	// Start of next frame
 	}
-	float LastFrameTime() const { return lastFrameTime; }
+	// Time to advance the scene by, fixed if set (e.g. for benchmarking) otherwise the real frame time
+	float LastFrameTime() const { return (fixedTimestep > 0) ? fixedTimestep : lastFrameTime; }
+	void SetFixedTimestep(float seconds) { fixedTimestep = seconds; }
 
 	std::string LatestFPS() const
 	{
 		return dataLine;
 	}
 
+	FrameStats GetStats() const
+	{
+		FrameStats stats{ historyCount, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, stutters };
+		if (historyCount == 0)
+			return stats;
+
+		std::vector<float> sorted(History());
+		std::sort(sorted.begin(), sorted.end());
+		auto percentile = [&sorted](float p) { return sorted[std::min(sorted.size() - 1, (size_t)(p * sorted.size()))]; };
+		stats.average = (float)(historyTotal / historyCount);
+		stats.p50 = percentile(0.50f);
+		stats.p95 = percentile(0.95f);
+		stats.p99 = percentile(0.99f);
+		stats.max = sorted.back();
+		return stats;
+	}
+
+	// One line per bucket, each twice the width of the previous one, e.g. "<16ms ####### 59"
+	std::string Histogram(float firstBucketMs = 4.0f, int numBuckets = 5, int barWidth = 30) const
+	{
+		std::vector<size_t> counts(numBuckets);
+		for (auto frameTime : History())
+		{
+			int bucket = 0;
+			for (float limit = firstBucketMs; bucket < numBuckets - 1 && frameTime >= limit; limit *= 2.0f)
+				bucket++;
+			counts[bucket]++;
+		}
+
+		std::stringstream ss;
+		size_t maxCount = std::max<size_t>(1, *std::max_element(counts.begin(), counts.end()));
+		float limit = firstBucketMs;
+		for (int bucket = 0; bucket < numBuckets; bucket++, limit *= 2.0f)
+		{
+			ss << (bucket < numBuckets - 1 ? "<" : ">") << (bucket < numBuckets - 1 ? limit : limit / 2.0f) << "ms ";
+			ss << std::string((counts[bucket] * barWidth + maxCount - 1) / maxCount, '#') << " " << counts[bucket] << "\n";
+		}
+		return ss.str();
+	}
+
+	// Frame times oldest first
+	std::vector<float> History() const
+	{
+		std::vector<float> frames;
+		size_t first = (historyPos + historySize - historyCount) % historySize;
+		for (size_t i = 0; i < historyCount; i++)
+			frames.push_back(history[(first + i) % historySize]);
+		return frames;
+	}
+
+	bool WriteCsv(const std::string& filename) const
+	{
+		std::ofstream file(filename);
+		file << "frame,ms\n";
+		auto frames = History();
+		for (size_t i = 0; i < frames.size(); i++)
+			file << i << "," << frames[i] << "\n";
+		return file.good();
+	}
+
+	bool WriteJson(const std::string& filename) const
+	{
+		auto stats = GetStats();
+		std::ofstream file(filename);
+		file << "{\n  \"frames\": " << stats.numFrames << ",\n  \"averageMs\": " << stats.average << ",\n  \"p50Ms\": " << stats.p50
+			<< ",\n  \"p95Ms\": " << stats.p95 << ",\n  \"p99Ms\": " << stats.p99 << ",\n  \"maxMs\": " << stats.max << ",\n  \"stutters\": " << stats.stutters << "\n}\n";
+		return file.good();
+	}
+
 private:
+	void AddToHistory(float frameTimeMs)
+	{
+		if (historyCount > 0 && frameTimeMs > 2.0f * historyTotal / historyCount)
+			stutters++;
+
+		if (historyCount == historySize)
+			historyTotal -= history[historyPos];
+		else
+			historyCount++;
+		history[historyPos] = frameTimeMs;
+		historyTotal += frameTimeMs;
+		historyPos = (historyPos + 1) % historySize;
+	}
+
 	std::chrono::time_point<std::chrono::high_resolution_clock> frame_start;
 	float frame_min, frame_max, frame_total, lastFrameTime;
+	float fixedTimestep;
 	int numFrames;
 	bool detailed;
 	std::string dataLine;
+
+	std::vector<float> history;	// Ring buffer of frame times in ms
+	size_t historyPos, historyCount;
+	double historyTotal;
+	size_t stutters;
 };
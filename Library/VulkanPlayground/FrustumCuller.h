@@ -0,0 +1,36 @@
+#pragma once
+
+#include "Common.h"
+
+class Model;
+class CameraOrientator;
+
+// Bounding volumes tested against the view frustum four at a time (with SSE where available), giving the objects to draw
+// Each volume is a center with a box half size and a sphere radius, so boxes have no radius and spheres no size
+// They're kept as separate arrays of each component, so a batch of objects loads straight into the SIMD registers
+class FrustumCuller
+{
+public:
+	void Clear();
+	uint32_t AddSphere(const glm::vec3& center, float sphereRadius);	// Returns the object's index
+	uint32_t AddBox(const glm::vec3& min, const glm::vec3& max);
+	uint32_t AddModel(Model& model, const glm::mat4& transform = glm::mat4(1.0f));	// Box around the model's extents once transformed
+	void SetSphere(uint32_t object, const glm::vec3& center, float sphereRadius);	// For objects that move
+	void SetBox(uint32_t object, const glm::vec3& min, const glm::vec3& max);
+	uint32_t GetNumObjects() const { return (uint32_t)radius.size(); }
+
+	// The objects are in the space the matrix transforms from, e.g. world space for projection * view
+	const std::vector<uint32_t>& Cull(const glm::mat4& viewProjection);
+	const std::vector<uint32_t>& Cull(const MVP& mvp) { return Cull(mvp.projection * mvp.view * mvp.model); }	// In model space
+	const std::vector<uint32_t>& Cull(const CameraOrientator& camera, const glm::mat4& projection);	// In world space
+	const std::vector<uint32_t>& GetVisible() const { return visible; }	// Indices of the last Cull, in the order added
+
+	// Normalised with the normals pointing inwards, for Vulkan's 0 to 1 depth range
+	static std::array<glm::vec4, 6> ExtractPlanes(const glm::mat4& viewProjection);
+
+private:
+	std::vector<float> centerX, centerY, centerZ;
+	std::vector<float> sizeX, sizeY, sizeZ;	// Half the box
+	std::vector<float> radius;
+	std::vector<uint32_t> visible;
+};
@@ -0,0 +1,55 @@
+#pragma once
+
+#include "Common.h"
+
+class VulkanSystem;
+
+// GPU time of the VulkanSystem::DebugStartRegion/DebugEndRegion regions, from timestamps written into the command buffers
+// Command buffers are recorded once and resubmitted, so each one gets its own block of queries which it resets when it starts
+class GpuProfiler : public ITidy
+{
+public:
+	GpuProfiler() : queryPool(nullptr), timestampPeriod(0.0f), timestampMask(0)
+	{}
+
+	void Create(VulkanSystem& system);	// Does nothing if the graphics queue doesn't support timestamps
+	bool Created() const { return queryPool != nullptr; }
+	void Tidy(VulkanSystem& system) override;
+
+	// Called as command buffers are recorded and freed
+	void BeginCommandBuffer(VkCommandBuffer commandBuffer);
+	void FreeCommandBuffer(VkCommandBuffer commandBuffer);
+	void StartRegion(VkCommandBuffer commandBuffer, const std::string& name);
+	void EndRegion(VkCommandBuffer commandBuffer);
+
+	// Picks up the results of any finished submissions without waiting, call once a frame
+	void CollectResults(const VulkanSystem& system);
+	// Smoothed milliseconds per region name
+	const std::map<std::string, float>& GetRegionTimes() const { return regionTimes; }
+	float GetRegionTime(const std::string& name) const;
+	std::string GetSummary() const;
+	void ResetRegionTimes() { regionTimes.clear(); }	// e.g. when the scene changes
+
+private:
+	struct Region
+	{
+		std::string name;
+		uint32_t startQuery, endQuery;
+	};
+	struct Block
+	{
+		uint32_t firstQuery, nextQuery;
+		std::vector<Region> regions;
+		std::vector<size_t> openRegions;	// Nesting
+	};
+
+	VkQueryPool queryPool;
+	float timestampPeriod;	// Nanoseconds per tick
+	uint64_t timestampMask;
+	std::map<VkCommandBuffer, Block> blocks;
+	std::vector<uint32_t> freeBlocks;	// First query of each unused block
+	std::map<std::string, float> regionTimes;
+
+	static const uint32_t queriesPerBlock = 64;
+	static const uint32_t maxBlocks = 32;
+};
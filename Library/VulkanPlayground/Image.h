@@ -58,6 +58,7 @@ public:
 		addressMode = VK_SAMPLER_ADDRESS_MODE_REPEAT;
 		borderColor = VK_BORDER_COLOR_INT_OPAQUE_BLACK;
 		compareOp = VK_COMPARE_OP_ALWAYS;
+		bindlessIndex = INVALID_VALUE;
 	}
 	uint32_t GetAnisotopyLevel() const { return anisotopyLevel; }
 	void SetAnisotopyLevel(uint32_t level) { anisotopyLevel = level; }
@@ -73,6 +74,9 @@ public:
 	void SetImageView(VkImageView imageView) { textureImageView = imageView; }
 	void CreateSampler(const VulkanSystem& system, const std::string& debugName) { textureSampler = VulkanPlayground::CreateSampler(system, mipLevels, anisotopyLevel, addressMode, borderColor, compareOp, debugName); }
 
+	// Index into the system's bindless texture table, registering the texture on first use (view and sampler need to be created)
+	uint32_t GetBindlessIndex(VulkanSystem& system);
+
 	virtual void Tidy(VulkanSystem& system) override;
 
 protected:
@@ -86,6 +90,7 @@ protected:
 	VkSamplerAddressMode addressMode;
 	VkBorderColor borderColor;
 	VkCompareOp compareOp;
+	uint32_t bindlessIndex;
 };
 
 class Texture : public TextureBase
@@ -9,4 +9,9 @@
 #include "WindowSystem.h"
 #include "System.h"
 #include "Descriptor.h"
+#include "Bindless.h"
 #include "EventData.h"
+#include "DrawList.h"
+#include "IndirectDraw.h"
+#include "FrustumCuller.h"
+#include "CpuProfiler.h"
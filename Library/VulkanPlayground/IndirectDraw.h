@@ -0,0 +1,70 @@
+#pragma once
+
+#include "Common.h"
+#include "Buffers.h"
+
+class VulkanSystem;
+class Model;
+
+// Lots of objects drawn by one indirect draw rather than a draw call (and binds) each
+// The meshes are packed into a shared vertex and index buffer, then each frame the draw commands and per instance data are
+// written to host visible buffers. Only the indirect draw is recorded, so the command buffers don't need recording again
+// when the number of objects changes (up to the maximums given to Create), and adding objects costs a copy not API calls
+// Shaders read their instance's data from the instance buffer (as a storage buffer) indexed with gl_InstanceIndex,
+// which needs the drawIndirectFirstInstance feature, see VulkanPlayground::EnableIndirectDrawing
+// Use one per pipeline, the meshes must all have the vertex layout the pipeline expects
+class IndirectDraw : public ITidy
+{
+public:
+	IndirectDraw() : vertexStride(0), maxDraws(0), maxInstances(0), instanceDataSize(0), numDraws(0), numInstances(0), clearedDraws(0),
+		commands(nullptr), drawCount(nullptr), instanceData(nullptr), cmdDrawIndexedIndirectCount(nullptr), multiDraw(false)
+	{}
+
+	uint32_t AddMesh(const Model& model);	// Before Create, returns the id to draw it with
+	void Create(VulkanSystem& system, uint32_t maxNumDraws, uint32_t maxNumInstances, uint32_t dataSizePerInstance, const std::string& debugName);
+	bool Created() const { return drawBuffer.Created(); }
+	void Tidy(VulkanSystem& system) override;
+
+	// Each frame (e.g. in UpdateScene) the draws are added between Begin and End, in the order they're to be drawn
+	// Like the uniform buffers, there's one copy of the data shared by all the command buffers
+	void Begin();
+	void* AddDraw(uint32_t mesh, uint32_t instanceCount);	// Returns where to write the instances' data, nullptr when full
+	template <class T> bool AddInstance(uint32_t mesh, const T& data)
+	{
+		auto instance = AddDraw(mesh, 1);
+		if (instance != nullptr)
+			memcpy(instance, &data, std::min<size_t>(sizeof(T), instanceDataSize));
+		return instance != nullptr;
+	}
+	void End();
+
+	// Binds the meshes' buffers and draws, the pipeline and descriptors should already be bound
+	void Record(VkCommandBuffer commandBuffer);
+
+	Buffer& GetInstanceBuffer() { return instanceBuffer; }	// For the descriptor, see Descriptor::AddStorageBuffer
+	uint32_t GetNumDraws() const { return numDraws; }
+	uint32_t GetNumInstances() const { return numInstances; }
+
+private:
+	struct Mesh
+	{
+		uint32_t indexCount, firstIndex;
+		int32_t vertexOffset;
+	};
+	std::vector<Mesh> meshes;
+	std::vector<char> vertices;	// Of all the meshes, until they're copied to the GPU
+	std::vector<uint32_t> indices;
+	uint32_t vertexStride;
+	Buffer vertexBuffer, indexBuffer;
+
+	uint32_t maxDraws, maxInstances, instanceDataSize;
+	uint32_t numDraws, numInstances;
+	uint32_t clearedDraws;	// Commands after this have no instances, so don't need clearing
+	Buffer drawBuffer;	// The commands followed by their count
+	Buffer instanceBuffer;
+	VkDrawIndexedIndirectCommand* commands;	// Mapped for the life of the buffers
+	uint32_t* drawCount;
+	char* instanceData;
+	PFN_vkCmdDrawIndexedIndirectCountKHR cmdDrawIndexedIndirectCount;	// When supported, only the commands in use are drawn
+	bool multiDraw;	// Otherwise an indirect draw per command
+};
@@ -2,6 +2,8 @@
 
 #include "Common.h"
 #include "Shader.h"
+#include <mutex>
+#include <future>
 
 class RenderPass;
 class Descriptor;
@@ -20,12 +22,16 @@ class Pipeline : public ITidy
 {
 public:
 	Pipeline();
+	~Pipeline();
 
 	void DerivePipeline(const Pipeline& parentPipeline);
 
 	void SetupVertexDescription(const std::vector<Attribs::Attrib>& attribs);
 
 	void Create(VulkanSystem& system, VkDescriptorSetLayout descriptorSetLayout, const RenderPass& renderPass, const std::string& debugName);
+	// Deferred creation, Prepare on the main thread then build a batch of pipelines concurrently
+	void Prepare(VulkanSystem& system, VkDescriptorSetLayout descriptorSetLayout, const RenderPass& renderPass, const std::string& debugName);
+	static void CreatePipelines(VulkanSystem& system, const std::vector<Pipeline*>& preparedPipelines);
 
 	void Bind(VkCommandBuffer commandBuffer, VkDescriptorSet descriptorSet = nullptr, uint32_t dynamicOffset = INVALID_VALUE) const;
 	void Bind(VkCommandBuffer commandBuffer, const Descriptor& descriptor) const;
@@ -34,10 +40,23 @@ public:
 
 	Shader& LoadShader(VulkanSystem& system, const std::string& shaderName) { return LoadShaderDiffNames(system, shaderName, shaderName); }
 	Shader& LoadShaderWithGeomShader(VulkanSystem& system, const std::string& shaderName, const std::string& dirHint = PROJECT_NAME) { return LoadShaderDiffNames(system, shaderName, shaderName, shaderName, dirHint); }
-	Shader& LoadShaderDiffNames(VulkanSystem& system, const std::string& vertexShader, const std::string& fragmentShader = "", const std::string& geometryShader = "", const std::string& dirHint = PROJECT_NAME);
-
-	void AddPushConstant(VulkanSystem& system, uint32_t dataSize, VkShaderStageFlagBits stage);
+	Shader& LoadShaderDiffNames(VulkanSystem& system, const std::string& vertexShader, const std::string& fragmentShader = "", const std::string& geometryShader = "", const std::string& dirHint = PROJECT_NAME, const std::vector<std::string>& defines = {});
+	Shader& LoadShaderWithDefines(VulkanSystem& system, const std::string& shaderName, const std::vector<std::string>& defines) { return LoadShaderDiffNames(system, shaderName, shaderName, "", PROJECT_NAME, defines); }
+
+	void AddPushConstant(VulkanSystem& system, uint32_t dataSize, VkShaderStageFlags stage, uint32_t offset = 0);	// PushConstant's data is then from the offset
+	// Layouts from the loaded shaders' SPIR-V rather than hand written, layouts with the same bindings are shared (see VulkanSystem::GetDescriptorSetLayout)
+	void UseReflectedPushConstants(VulkanSystem& system);
+	VkDescriptorSetLayout GetReflectedDescriptorSetLayout(VulkanSystem& system, const std::string& debugName, uint32_t set = 0) const;
+	const Shader& GetShader() const { return shader; }
 	void PushConstant(VkCommandBuffer commandBuffer, const void* data);
+	uint32_t GetPushConstantSize() const { return pushConstantRange.size; }	// Of the data PushConstant takes, 0 for none
+	// Extra descriptor sets (e.g. the bindless texture table) after the main one
+	void AddDescriptorSetLayout(VkDescriptorSetLayout layout) { extraDescriptorSetLayouts.push_back(layout); }
+	void BindDescriptorSet(VkCommandBuffer commandBuffer, uint32_t set, VkDescriptorSet descriptorSet) const;
+	// Write the resources for a push descriptor (see Descriptor::CreatePushDescriptor) straight into the command buffer
+	template <class T> void PushDescriptor(VkCommandBuffer commandBuffer, const Descriptor& descriptor, const T& data, uint32_t set = 0) const
+		{ PushDescriptorData(commandBuffer, descriptor, &data, sizeof(data), set); }
+	void PushDescriptorData(VkCommandBuffer commandBuffer, const Descriptor& descriptor, const void* data, size_t dataSize, uint32_t set = 0) const;
 
 	void SetPolygonMode(VkPolygonMode value) { rasterizer.polygonMode = value; }
 	void SetLineWidth(float value) { rasterizer.lineWidth = value; }
@@ -65,14 +84,42 @@ public:
 
 	void Recreate() { recreate = true; }
 	bool CheckRecreate(VulkanSystem& system, RenderPass& renderPass);
+	// Shader files have been reloaded, rebuild in the background and swap over in CheckRecreate once ready
+	void ShaderModulesChanged(VulkanSystem& system, const std::map<std::string, VkShaderModule>& changedFiles);
+
+	// Only the specialization data has changed, switch to the matching variant (building it if not seen before) rather than recreating
+	void SpecializationChanged() { specializationChanged = true; }
+	// Build variants of a stage's specialization data in the background so later switches don't stall
+	template <class T> void PrewarmVariants(VulkanSystem& system, VkShaderStageFlagBits stage, const std::vector<T>& variantData)
+	{
+		std::vector<std::string> variants;
+		for (auto& variant : variantData)
+			variants.emplace_back((const char*)&variant, sizeof(T));
+		PrewarmVariantData(system, stage, variants);
+	}
+	void PrewarmVariantData(VulkanSystem& system, VkShaderStageFlagBits stage, const std::vector<std::string>& variantData);
 
 protected:
 	Pipeline& operator=(const Pipeline& other);
 
 private:
+	void SetupStateKey(const VulkanSystem& system, VkDescriptorSetLayout descriptorSetLayout, const RenderPass& renderPass);
+	void Build(VulkanSystem& system);
+	void CompleteCreation(VulkanSystem& system);
+	void Destroy(VulkanSystem& system);
+	VkPipelineLayout CreatePipelineLayout(VulkanSystem& system) const;
+	bool CheckReload(VulkanSystem& system);
+	void CancelReload(VulkanSystem& system);
+
+	std::string GetVariantKey(VkShaderStageFlagBits stage = VK_SHADER_STAGE_ALL, const std::string* stageData = nullptr) const;
+	static VkPipeline BuildVariant(VulkanSystem& system, const VkGraphicsPipelineCreateInfo& createInfo, VkShaderStageFlagBits stage = VK_SHADER_STAGE_ALL, const std::string* stageData = nullptr);
+	VkPipeline FindVariant(const std::string& key);
+	void AddVariant(VulkanSystem& system, const std::string& key, VkPipeline variant);
+
 	VkPipelineLayout pipelineLayout;
 	VkPipeline pipeline;
 	Shader shader;
+	PFN_vkCmdPushDescriptorSetKHR cmdPushDescriptorSet;	// From the system, so push descriptors can be recorded without it
 
 	VertexDescription vertexDescription;
 	std::vector<VkDynamicState> dynamicStateEnables;
@@ -88,8 +135,30 @@ private:
 	std::vector<VkPipelineColorBlendAttachmentState> colorBlendAttachments;
 	VkPipelineColorBlendStateCreateInfo colorBlending{ VK_STRUCTURE_TYPE_PIPELINE_COLOR_BLEND_STATE_CREATE_INFO };
 	VkPipelineDepthStencilStateCreateInfo depthStencil{ VK_STRUCTURE_TYPE_PIPELINE_DEPTH_STENCIL_STATE_CREATE_INFO };
+	VkPipelineDynamicStateCreateInfo dynamicState{ VK_STRUCTURE_TYPE_PIPELINE_DYNAMIC_STATE_CREATE_INFO };
 	VkGraphicsPipelineCreateInfo pipelineInfo{ VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_CREATE_INFO };
 
 	bool recreate;
 	VkDescriptorSetLayout descriptorSetLayoutUsed;
+	std::vector<VkDescriptorSetLayout> extraDescriptorSetLayouts;
+	const Pipeline* basePipeline;	// Set for derived pipelines, handle is looked up when built
+	std::string name;
+	StateKey stateKey;	// Used to share the pipeline with others using identical state
+
+	bool specializationChanged;
+	VkPipeline primaryPipeline;	// The one originally created, other variants are owned by this pipeline
+	std::map<std::string, VkPipeline> variants;	// Keyed on specialization data
+	std::mutex variantsMutex;
+	std::future<void> prewarmTask;
+	struct VariantSource	// Copy of the create info and specialization data, so the prewarm doesn't read state the main thread can change
+	{
+		VkGraphicsPipelineCreateInfo pipelineInfo;
+		std::vector<VkPipelineShaderStageCreateInfo> stages;
+		std::vector<VkSpecializationInfo> specializationInfos;
+		std::vector<std::vector<VkSpecializationMapEntry>> mapEntries;
+		std::vector<std::string> specializationData;
+	};
+
+	std::future<VkPipeline> reloadTask;	// Rebuild with reloaded shaders
+	VkPipelineLayout reloadLayout;
 };
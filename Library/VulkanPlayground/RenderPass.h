@@ -40,6 +40,7 @@ public:
 
 	bool IsSwapChainImage(uint32_t index) const { return renderAttachmentsUseSwapChainImage[index]; }
 	bool IsInputAttachment(uint32_t index) const;
+	bool IsTransientAttachment(uint32_t index) const;
 	VkFormat GetAttachmentFormat(uint32_t index) const;
 
 	void SwitchOutputToAttachment();
@@ -50,6 +51,7 @@ public:
 
 	void Create(VulkanSystem &system, const std::string& debugName);
 	VkRenderPass Get() const { return renderPass; }
+	const StateKey& GetCompatibilityKey() const { return compatibilityKey; }
 	void Tidy(VulkanSystem& system) override;
 
 	void Begin(VkFramebuffer frameBuffer, VkCommandBuffer commandBuffer, const VkExtent2D& extent);
@@ -73,6 +75,9 @@ public:
 		return renderFinished.get();
 	}
 	VkSemaphore GetWaitSemaphore() const { return imageAvailable.get(); }
+	VkSemaphore GetFinishedSemaphore() const { return renderFinished.get(); }
+	VkCommandBuffer GetCommandBuffer(uint32_t imageIndex) const { return displayBuffers.GetCommandBuffer(imageIndex); }
+	const ApiCallCounts& GetApiCalls(uint32_t imageIndex) const { return displayBuffers.GetApiCalls(imageIndex); }
 
 	DisplayBuffers& GetDisplayBuffers() { return displayBuffers; }
 
@@ -90,7 +95,10 @@ protected:
 	DisplayBuffers displayBuffers;
 
 private:
+	std::vector<VkSubpassDependency> CreateDependencies() const;
+
 	VkRenderPass renderPass;
+	StateKey compatibilityKey;
 
 	std::vector<VkAttachmentDescription> renderAttachments;
 	std::vector<std::string> renderAttachmentsNames;
@@ -141,6 +149,9 @@ public:
 	{
 		return renderPasses[pass]->SubmitCommandBuffer(imageIndex, queue, waitSemaphores, waitStage);
 	}
+	// Submit all the screen renderpasses together, their external subpass dependencies order them so no semaphores are needed in between
+	// Without presenting (headless) nothing waits on the finished semaphore, so it isn't signalled and the fence is used instead
+	VkSemaphore SubmitCommandBuffers(uint32_t imageIndex, VkQueue queue, const std::vector<VkSemaphore>& waitSemaphores, const std::vector<VkPipelineStageFlags>& waitStages, VkFence fence = VK_NULL_HANDLE, bool signalFinished = true);
 	VkSemaphore GetInitialWaitSemaphore()
 {
 		return renderPasses[0]->GetWaitSemaphore();
@@ -1,6 +1,7 @@
 #pragma once
 
 #include "Common.h"
+#include "ShaderReflection.h"
 
 class SpecializationObject
 {
@@ -25,13 +26,17 @@ private:
 class Shader : public ITidy
 {
 public:
-	void Load(VulkanSystem& system, const std::string& vertexShader, const std::string& fragmentShader, const std::string& geometryShader);
+	// Defines need the runtime compile path (see VulkanSystem::FindCompiledModule)
+	void Load(VulkanSystem& system, const std::string& vertexShader, const std::string& fragmentShader, const std::string& geometryShader, const std::vector<std::string>& defines = {});
 	void Tidy(VulkanSystem& system) override;
 
 	bool Matches(VkShaderModule vertex, VkShaderModule fragment, VkShaderModule geometry) const
 	{
 		return (vertexModule == vertex && fragmentModule == fragment && geometryModule == geometry);
 	}
+	bool ReplaceModules(const std::map<std::string, VkShaderModule>& changedFiles);	// See VulkanSystem::CheckShaderChanges
+	// Resources used by all the stages, read from the SPIR-V when loaded
+	const ShaderReflection& GetReflection() const { return reflection; }
 	uint32_t NumShaders() const { return (uint32_t)shaderStages.size(); }
 	const VkPipelineShaderStageCreateInfo* StageData() const { return shaderStages.data(); }
 	VkPipelineShaderStageCreateInfo& FindShader(VkShaderStageFlagBits shader);
@@ -47,7 +52,9 @@ public:
 
 private:
 	VkShaderModule vertexModule, fragmentModule, geometryModule;
+	std::string vertexFile, fragmentFile, geometryFile;	// Keys of the files they were loaded from
 	std::vector<VkPipelineShaderStageCreateInfo> shaderStages;
+	ShaderReflection reflection;
 
 	SpecializationObject specializationObject[2];	// One for vertex and one for fragment shaders
 	SpecializationObject* GetSpecializationObject(VkShaderStageFlagBits shader);
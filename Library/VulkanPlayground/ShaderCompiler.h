@@ -0,0 +1,17 @@
+#pragma once
+
+// Optional runtime GLSL to SPIR-V compilation, using the shaderc library from the Vulkan SDK (loaded on first compile)
+// Outputs are cached on disk keyed on the source and defines, so warm runs only read the cached SPIR-V
+class ShaderCompiler
+{
+public:
+	// shaderName is as used for the .spv, e.g. "Basics\\cube.vert", returns an empty string if the source can't be found
+	std::string FindSource(const std::string& shaderName);
+	// Defines are "NAME" or "NAME=VALUE"
+	void Compile(const std::string& sourceFile, const std::vector<std::string>& defines, std::vector<char>& spirv);
+
+private:
+	std::string GetCacheFile(const std::string& source, const std::string& sourceFile, const std::vector<std::string>& defines);
+
+	std::map<std::string, std::string> sourceFiles;	// Shader name to source path
+};
@@ -0,0 +1,21 @@
+#pragma once
+
+// Descriptor bindings and push constant range used by shaders, read from the SPIR-V
+// Uniform buffers are reported as VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER (dynamic or not is up to the app), runtime arrays with a count of 0
+class ShaderReflection
+{
+public:
+	ShaderReflection() : pushConstantRange{}
+	{}
+
+	void Reflect(const std::vector<char>& spirv);
+	void Merge(const ShaderReflection& other);	// Combine the stages of a pipeline
+
+	uint32_t NumSets() const { return sets.empty() ? 0 : sets.rbegin()->first + 1; }
+	std::vector<VkDescriptorSetLayoutBinding> GetBindings(uint32_t set) const;
+	const VkPushConstantRange& GetPushConstantRange() const { return pushConstantRange; }
+
+private:
+	std::map<uint32_t, std::map<uint32_t, VkDescriptorSetLayoutBinding>> sets;	// Set -> binding
+	VkPushConstantRange pushConstantRange;
+};
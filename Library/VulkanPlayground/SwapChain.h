@@ -5,6 +5,7 @@
 #include "DisplayBuffers.h"
 
 class RenderPass;
+class FrameCapture;
 
 struct SwapChainSupportDetails
 {
@@ -18,6 +19,7 @@ class SwapChain : public ITidy
 {
 public:
 	SwapChain();
+	// Without a surface (headless) frames are rendered into a chain of plain images instead, nothing is presented
 	void Create(VulkanSystem &system, VkSurfaceKHR windowSurface, uint32_t width, uint32_t height, bool vSync, const std::string& debugName);
 	void Tidy(VulkanSystem& system) override;
 
@@ -31,8 +33,13 @@ public:
 	VkExtent2D &GetWorkingExtent() { return workingExtent; }
 	VkFormat GetImageFormat() const { return swapChainImageFormat.format; }
 	uint32_t GetImageCount() const { return imageCount; }
+	bool Headless() const { return !headlessImages.empty(); }
+	void CaptureLastFrame(VulkanSystem& system, FrameCapture& capture);	// Headless only, presented images can't be read back
 
 private:
+	void CreateHeadless(VulkanSystem& system, uint32_t width, uint32_t height, const std::string& debugName);
+	bool DrawHeadlessFrame(VulkanSystem& system, RenderPasses& renderPasses);
+
 	VkSwapchainKHR swapChain;
 	SwapChainSupportDetails swapChainDetails;
 	VkSurfaceFormatKHR swapChainImageFormat;
@@ -42,4 +49,8 @@ private:
 
 	VkQueue graphicsQueue{};
 	VkQueue presentQueue{};
+
+	std::vector<Image> headlessImages;
+	std::vector<VkFence> headlessFences;	// Per image, so a frame isn't rendered into an image still in use
+	uint32_t nextHeadlessImage, lastHeadlessImage;
 };
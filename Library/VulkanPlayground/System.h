@@ -4,6 +4,11 @@ class Extensions;
 class VulkanApplication;
 
 #include "Buffers.h"
+#include "Bindless.h"
+#include "ShaderCompiler.h"
+#include "ShaderReflection.h"
+#include "GpuProfiler.h"
+#include <filesystem>
 
 struct QueueIndicies
 {
@@ -54,7 +59,26 @@ public:
 	void FindDevice(VkInstance instance, VkSurfaceKHR windowSurface, const Extensions& extensions);
 	void Setup(const Extensions& extensions, VulkanApplication& app);
 	void TidyUp();
-	bool FindModule(const std::string& shaderFilename, VkShaderModule& shaderModule);
+	// Modules are shared by content, so the same SPIR-V under different names is only created once
+	// fileKey identifies the loaded file, which is how CheckShaderChanges reports it
+	bool FindModule(const std::string& shaderFilename, VkShaderModule& shaderModule, std::string* fileKey = nullptr);
+	// Polls the loaded shader files, returns true and the new module for each file key that has changed on disk
+	bool CheckShaderChanges(std::map<std::string, VkShaderModule>& changedFiles);
+	void EnableShaderHotReload(bool enable) { shaderHotReload = enable; }
+	// Compile from the GLSL source (cached on disk) rather than loading the prebuilt .spv, shaderName excludes the .spv
+	bool FindCompiledModule(const std::string& shaderName, const std::vector<std::string>& defines, VkShaderModule& shaderModule, std::string* fileKey = nullptr);
+	void EnableRuntimeShaderCompile(bool enable) { runtimeShaderCompile = enable; }
+	bool RuntimeShaderCompile() const { return runtimeShaderCompile; }
+	const ShaderReflection& GetModuleReflection(VkShaderModule shaderModule) const;
+
+	// Pipelines are shared between all users with matching state, unused ones are kept (up to a limit) so they can be reused later
+	bool FindPipeline(const StateKey& key, VkPipeline& pipeline, VkPipelineLayout& pipelineLayout);
+	void AddPipeline(const StateKey& key, VkPipeline& pipeline, VkPipelineLayout& pipelineLayout);
+	bool ReleasePipeline(VkPipeline pipeline);
+	void TidyPipelineCache();
+	// Descriptor set layouts are shared by everything with the same bindings, and kept until the device is destroyed
+	VkDescriptorSetLayout GetDescriptorSetLayout(const std::vector<VkDescriptorSetLayoutBinding>& bindings, const std::string& debugName, VkDescriptorSetLayoutCreateFlags flags = 0);
+	const StateKey* GetDescriptorSetLayoutKey(VkDescriptorSetLayout layout) const;
 
 	VkPhysicalDevice GetPhysicalDevice() const { return physicalDevice; }
 	QueueIndicies GetQueueIndicies() const { return queueIndicies; }
@@ -65,6 +89,7 @@ public:
 		{ bufMan.CreateGpuBuffer(system, buffer, data.data(), sizeof(data[0]) * data.size(), usage, debugName); 	}
 	QueuePool &GetGraphicsQueuePool() { return bufMan.GetGraphicsQueuePool(); }
 	VkDevice GetDevice() const { return device; }
+	VkPipelineCache GetPipelineCache() const { return pipelineCache; }
 	void DeviceWaitIdle();
 
 	const VkPhysicalDeviceProperties& GetDeviceProperties()
@@ -77,9 +102,31 @@ public:
 		return *deviceProps;
 	}
 	VkPhysicalDeviceFeatures GetDeviceFeatures() const { return deviceFeatures; }
+	const VkPhysicalDeviceFeatures& GetEnabledDeviceFeatures() const { return requestedDeviceFeatures; }
+	bool BindlessSupported() const { return bindlessSupported; }
+	bool PushDescriptorsSupported() const { return vkCmdPushDescriptorSetKHR != nullptr; }
+	PFN_vkCmdPushDescriptorSetKHR GetCmdPushDescriptorSet() const { return vkCmdPushDescriptorSetKHR; }	// nullptr when not supported
+	// Core in Vulkan 1.1, otherwise from the extension, see Descriptor::CreateUpdateTemplate
+	bool UpdateTemplatesSupported() const { return vkCreateDescriptorUpdateTemplateKHR != nullptr; }
+	VkResult CreateDescriptorUpdateTemplate(const VkDescriptorUpdateTemplateCreateInfo& templateInfo, VkDescriptorUpdateTemplate* updateTemplate) const
+		{ return vkCreateDescriptorUpdateTemplateKHR(device, &templateInfo, nullptr, updateTemplate); }
+	void DestroyDescriptorUpdateTemplate(VkDescriptorUpdateTemplate updateTemplate) const { vkDestroyDescriptorUpdateTemplateKHR(device, updateTemplate, nullptr); }
+	void UpdateDescriptorSetWithTemplate(VkDescriptorSet descriptorSet, VkDescriptorUpdateTemplate updateTemplate, const void* data) const
+		{ vkUpdateDescriptorSetWithTemplateKHR(device, descriptorSet, updateTemplate, data); }
+	PFN_vkCmdDrawIndexedIndirectCountKHR GetDrawIndexedIndirectCount() const { return vkCmdDrawIndexedIndirectCountKHR; }	// nullptr when not supported
+	BindlessTextures& GetBindlessTextures(uint32_t numTextures = 1);	// Created on first use, sized for the textures needed within the device's limits
+	void UnregisterBindlessTexture(uint32_t index) { if (bindlessTextures.Created()) bindlessTextures.Unregister(index); }
+	GpuProfiler& GetGpuProfiler() { return gpuProfiler; }
+	// Device memory allocated for buffers and images
+	void MemoryAllocated(VkDeviceSize size) { deviceMemory += size; peakDeviceMemory = std::max(peakDeviceMemory, deviceMemory); }
+	void MemoryFreed(VkDeviceSize size) { deviceMemory -= size; }
+	VkDeviceSize GetDeviceMemory() const { return deviceMemory; }
+	VkDeviceSize GetPeakDeviceMemory() const { return peakDeviceMemory; }
+	void ResetPeakDeviceMemory() { peakDeviceMemory = deviceMemory; }
 
 	VkFormat FindSupportedFormat(const std::vector<VkFormat>& candidates, VkImageTiling tiling, VkFormatFeatureFlags features);
 	uint32_t FindMemoryType(uint32_t typeFilter, VkMemoryPropertyFlags properties);
+	bool HasMemoryType(uint32_t typeFilter, VkMemoryPropertyFlags properties) { uint32_t memoryType; return FindMemoryType(typeFilter, properties, memoryType); }
 
 	void IncDebugOutput(uint32_t depth) { debugOutputIndent += depth; }
 	void DecDebugOutput(uint32_t depth) { debugOutputIndent -= depth; }
@@ -87,8 +134,9 @@ public:
 	void DebugNameObject(void* object, VkObjectType objectType, const std::string& type, const std::string& desc) const { debugMarker.NameObject(device, object, objectType, debugOutputIndent, type, desc); }
 	typedef float ColType[3];
 	void DebugInsertLabel(VkCommandBuffer commandBuffer, const std::string& label, const ColType& colour = ColType{ 0 }) { debugMarker.InsertLabel(commandBuffer, label, colour); }
-	void DebugStartRegion(VkCommandBuffer commandBuffer, const std::string& label, const ColType& colour = ColType{ 0 }) { debugMarker.StartRegion(commandBuffer, label, colour); }
-	void DebugEndRegion(VkCommandBuffer commandBuffer) { debugMarker.EndRegion(commandBuffer); }
+	// Command buffer regions are also timed by the GPU profiler
+	void DebugStartRegion(VkCommandBuffer commandBuffer, const std::string& label, const ColType& colour = ColType{ 0 }) { debugMarker.StartRegion(commandBuffer, label, colour); gpuProfiler.StartRegion(commandBuffer, label); }
+	void DebugEndRegion(VkCommandBuffer commandBuffer) { gpuProfiler.EndRegion(commandBuffer); debugMarker.EndRegion(commandBuffer); }
 	void DebugInsertLabel(VkQueue queue, const std::string& label, const ColType& colour = ColType{ 0 }) { debugMarker.InsertLabel(queue, label, colour); }
 	void DebugStartRegion(VkQueue queue, const std::string& label, const ColType& colour = ColType{ 0 }) { debugMarker.StartRegion(queue, label, colour); }
 	void DebugEndRegion(VkQueue queue) { debugMarker.EndRegion(queue); }
@@ -96,6 +144,8 @@ public:
 	bool fontsEnabled;
 
 private:
+	bool FindMemoryType(uint32_t typeFilter, VkMemoryPropertyFlags properties, uint32_t& memoryType);
+
 	VkPhysicalDevice physicalDevice;
 	VkPhysicalDeviceProperties* deviceProps;
 	VkPhysicalDeviceFeatures deviceFeatures;
@@ -104,6 +154,49 @@ private:
 	uint32_t debugOutputIndent;
 	DebugMarker debugMarker;
 	VkDevice device;
+	VkPipelineCache pipelineCache;	// Shared by all pipelines, safe to use from multiple threads
 	VkPhysicalDeviceFeatures requestedDeviceFeatures;
-	std::map<std::string, VkShaderModule> shaderModules;
+	bool bindlessSupported;
+	PFN_vkCmdPushDescriptorSetKHR vkCmdPushDescriptorSetKHR;
+	PFN_vkCmdDrawIndexedIndirectCountKHR vkCmdDrawIndexedIndirectCountKHR;
+	PFN_vkCreateDescriptorUpdateTemplateKHR vkCreateDescriptorUpdateTemplateKHR;
+	PFN_vkDestroyDescriptorUpdateTemplateKHR vkDestroyDescriptorUpdateTemplateKHR;
+	PFN_vkUpdateDescriptorSetWithTemplateKHR vkUpdateDescriptorSetWithTemplateKHR;
+	BindlessTextures bindlessTextures;
+	GpuProfiler gpuProfiler;
+	VkDeviceSize deviceMemory, peakDeviceMemory;
+	struct ShaderFile
+	{
+		uint64_t hash;
+		VkShaderModule module;
+		std::filesystem::file_time_type writeTime;
+		std::string path;
+		std::vector<std::string> defines;
+		bool compiled;	// From GLSL source
+	};
+	struct SharedModule
+	{
+		VkShaderModule module;
+		std::vector<char> code;	// Compared on a hash match, so a collision doesn't share the wrong shader
+	};
+	VkShaderModule GetModuleForCode(const std::vector<char>& shaderCode, uint64_t hash, const std::string& debugName, bool& existing);
+	std::map<std::string, ShaderFile> shaderFiles;
+	std::multimap<uint64_t, SharedModule> shaderModules;	// Keyed on content hash
+	std::map<VkShaderModule, ShaderReflection> moduleReflections;
+	bool shaderHotReload;
+	std::chrono::steady_clock::time_point lastShaderCheck;
+	bool runtimeShaderCompile;
+	ShaderCompiler shaderCompiler;
+
+	struct CachedPipeline
+	{
+		VkPipeline pipeline;
+		VkPipelineLayout pipelineLayout;
+		uint32_t refCount;
+	};
+	std::map<std::string, CachedPipeline> pipelines;
+	std::list<std::string> unusedPipelines;	// Oldest first
+	static const size_t maxUnusedPipelines = 64;
+	std::map<std::string, VkDescriptorSetLayout> descriptorSetLayouts;
+	std::map<VkDescriptorSetLayout, StateKey> descriptorSetLayoutKeys;
 };
@@ -44,7 +44,7 @@ TypeSetter& TextHelperBase::PrintString(TypeSetter& typeSetter, const UnicodeStr
 
 TextHelperBase::TextHelperBase()
 	: 
-	generalKeys("General|F11,Toggle Full screen|R,Reset scene|P,Show FPS|Shift+P,Toggle vSync|Escape,exit"),
+	generalKeys("General|F11,Toggle Full screen|R,Reset scene|P,Show FPS/frame stats|Shift+P,Toggle vSync|F12,Start/stop CPU trace|Escape,exit"),
 	movementKeys("3d movement|Left button + mouse,Look around|Right button + mouse,Rotate world|Mouse wheel,Zoom|WASD,Move around"),
 	lightKeys("Light|1,Toggle ambient light|2,Toggle diffuse light|3,Toggle specular light")
 {
@@ -53,6 +53,9 @@ TextHelperBase::TextHelperBase()
 void TextHelperBase::SetupText(VkExtent2D workingExtent)
 {
 	AddPrintString("fps:(1234567890)vSync");
+	AddPrintString("GPU:.,ms DrawScene2dFontDrawing");	// GPU region times
+	AddPrintString("p<>#maxstutters");	// Frame stats
+	AddPrintString("BindPipelineDescriptorSetsVertexIndexPushConstantsDrawIndirectDispatchQueueSubmitAllocateMemoryUpdate");	// API call counts
 	AddPrintString(generalKeys);
 	AddPrintString(movementKeys);
 	AddPrintString(lightKeys);
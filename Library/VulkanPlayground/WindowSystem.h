@@ -3,17 +3,44 @@
 #include "GLFW.h"
 #include "Extensions.h"
 #include "System.h"
+#include "FrameTimer.h"
+#include "FrameCapture.h"
+#include "ApiCounters.h"
+
+// Measurements from the last RunApp, e.g. for benchmarking
+struct RunStats
+{
+	double setupMs;	// From starting the app to the end of its first frame
+	FrameStats frameStats;	// Frames after the warm-up
+	std::map<std::string, float> gpuRegionTimes;	// ms, if the device supports timestamps
+	VkDeviceSize deviceMemory, peakDeviceMemory;	// Bytes allocated for buffers and images
+	ApiCallCounts apiCalls;	// In the last frame
+	bool goldenCompared;	// Last frame was captured and there was a golden image to compare it to
+	ImageComparison golden;
+};
 
 class WindowSystem
 {
 public:
-	WindowSystem() : instance(0), windowSurface(0) {}
+	WindowSystem() : instance(0), windowSurface(0), headless(false), headlessWidth(0), headlessHeight(0), frameLimit(0), warmupFrames(0), fixedTimestep(0.0f), captureTolerance(0), finished(false), lastRunStats{} {}
 	bool InitWindow(int windowWidth, int windowHeight, const std::string& windowName, GLFW::keyHandlerFn keyHandler = nullptr, void* keyHandlerData = nullptr);
-	void RunApp(VulkanApplication& app);
+	// No window or surface, frames are rendered to offscreen images (e.g. for benchmarking on a software implementation such as lavapipe)
+	bool InitHeadless(int width, int height, const std::string& name);
+	bool RunApp(VulkanApplication& app);	// False on a fatal error
 	void Close();
-	bool Running() { return window.Running(); }
+	bool Running() { return headless ? !finished : window.Running(); }
+	void SetFrameLimit(uint32_t frames) { frameLimit = frames; }	// 0 for no limit
+	void SetWarmupFrames(uint32_t frames) { warmupFrames = frames; }	// Run before the frame limit starts counting and not included in the stats
+	void SetFixedTimestep(float seconds) { fixedTimestep = seconds; }	// 0 for real time
+	// Fixed timestep and random seeds so runs (along with any replayed input) are reproducible
+	void SetDeterministic(uint32_t seed = 1, float timestep = 1.0f / 60.0f) { VulkanPlayground::randomSeed = seed; fixedTimestep = timestep; }
+	EventData& GetEventData() { return window.GetEventData(); }	// e.g. to record or replay input
+	// Headless runs that reach the frame limit save their last frame, and compare it against the golden image if that exists
+	void SetFrameCapture(const std::string& pngFile, const std::string& _goldenFile = "", uint32_t tolerance = 2) { captureFile = pngFile; goldenFile = _goldenFile; captureTolerance = tolerance; }
+	const RunStats& GetLastRunStats() const { return lastRunStats; }
 
 	static void RunWindowed(int width, int height, const std::string& name, VulkanApplication& app);
+	static bool RunHeadless(int width, int height, const std::string& name, VulkanApplication& app, uint32_t numFrames);
 
 	VulkanSystem& GetVulkanSystem() { return system; }
 
@@ -23,4 +50,13 @@ private:
 	Extensions extensions;
 	GLFW window;
 	VulkanSystem system;
+
+	bool headless;
+	int headlessWidth, headlessHeight;
+	uint32_t frameLimit, warmupFrames;
+	float fixedTimestep;
+	std::string captureFile, goldenFile;
+	uint32_t captureTolerance;
+	bool finished;	// Headless runs stop after the frame limit, or on an error
+	RunStats lastRunStats;
 };
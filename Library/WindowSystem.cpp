@@ -6,6 +6,7 @@
 #include "SwapChain.h"
 #include "RenderPass.h"
 #include "FrameTimer.h"
+#include "CpuProfiler.h"
 
 bool WindowSystem::InitWindow(int windowWidth, int windowHeight, const std::string& windowName, GLFW::keyHandlerFn keyHandler, void* keyHandlerData)
 {
@@ -20,6 +21,7 @@ bool WindowSystem::InitWindow(int windowWidth, int windowHeight, const std::stri
 		windowSurface = window.CreateSurface(instance);
 
 		system.FindDevice(instance, windowSurface, extensions);
+		extensions.EnableOptionalDeviceExtensions(system.GetPhysicalDevice());
 	}
 	catch (std::runtime_error & err)
 	{
@@ -29,11 +31,40 @@ bool WindowSystem::InitWindow(int windowWidth, int windowHeight, const std::stri
 	return true;
 }
 
-void WindowSystem::RunApp(VulkanApplication& app)
+bool WindowSystem::InitHeadless(int width, int height, const std::string& name)
 {
+	try
+	{
+		headless = true;
+		headlessWidth = width, headlessHeight = height;
+		extensions.Setup({});	// No surface extensions
+		instance = VulkanPlayground::CreateInstance(name, extensions);
+		extensions.SetupDebugCallback(instance, VulkanPlayground::DebugCallbackFn);
+
+		system.FindDevice(instance, nullptr, extensions);
+		extensions.EnableOptionalDeviceExtensions(system.GetPhysicalDevice());
+	}
+	catch (std::runtime_error & err)
+	{
+		WinUtils::OutputError("Failed to setup headless rendering, fatal error: " + std::string(err.what()));
+		return false;
+	}
+	return true;
+}
+
+bool WindowSystem::RunApp(VulkanApplication& app)
+{
+	bool succeeded = true;
+	finished = false;
+	lastRunStats = {};
+	auto startTime = std::chrono::high_resolution_clock::now();
+	if (VulkanPlayground::randomSeed != 0)
+		srand(VulkanPlayground::randomSeed);	// Same random numbers each run
 	app.Starting(system);
+	CpuProfiler::SetThreadName("Main");
 	SwapChain swapChain;
 	RenderPasses renderPasses;
+	FrameCapture frameCapture;
 
 	try
 	{
@@ -41,19 +72,40 @@ void WindowSystem::RunApp(VulkanApplication& app)
 		// Next line crashes!  Bug in VulkanSDK and/or graphics driver?
 		//system.DebugNameObject(instance, VK_OBJECT_TYPE_INSTANCE, "Main Vulkan Instance");	// This is here as need to create device before naming things
 
-		app.GetWindowSize(window);
+		if (headless)
+			app.SetWindowSize(headlessWidth, headlessHeight);
+		else
+			app.GetWindowSize(window);
 
 		FPSTimer fpsTimer;
-		bool minimised = false, windowShown = false;
+		fpsTimer.SetFixedTimestep(fixedTimestep);
+		system.GetGpuProfiler().ResetRegionTimes();	// From any previous app
+		system.ResetPeakDeviceMemory();
+		bool minimised = false, windowShown = headless;
+		uint32_t frameCount = 0;
 
 		while (Running())
 		{
-			MouseData mouseData;
-			if (window.PollEvents(mouseData))
-				app.AppProcessMouseMovement(mouseData);
+			PROFILE_ZONE("Frame");
+			if (!headless)
+			{
+				MouseData mouseData;
+				if (window.PollEvents(mouseData))
+					app.AppProcessMouseMovement(mouseData);
 
-			if (window.CheckFoKeyPresses(app))
-				break;
+				if (window.CheckFoKeyPresses(app))
+					break;
+			}
+			else if (window.GetEventData().Replaying())
+			{	// No window, but recorded input can still be played back
+				auto& eventData = window.GetEventData();
+				eventData.NextFrame();
+				MouseData mouseData;
+				if (eventData.GetMouseData(mouseData))
+					app.AppProcessMouseMovement(mouseData);
+				if (eventData.NewKeyPress())
+					app.AppProcessKeyPresses(eventData);
+			}
 
 			if (!app.ObjectsCreated(system, renderPasses))
 				app.SetupWindowObjects(swapChain, windowSurface, system, renderPasses);
@@ -84,7 +136,9 @@ void WindowSystem::RunApp(VulkanApplication& app)
 			{
 				okay = swapChain.DrawFrame(system, renderPasses);
 			}
-			if (!okay)
+			if (!okay && headless)
+				app.RecreateObjects();
+			else if (!okay)
 			{
 				app.GetWindowSize(window);
 				minimised = (app.GetWindowWidth() == 0) || (app.GetWindowHeight() == 0);
@@ -95,19 +149,62 @@ void WindowSystem::RunApp(VulkanApplication& app)
 				}
 			}
 			fpsTimer.Sample();
+			ApiCounters::NextFrame();
+			if (frameCount++ == 0)
+				lastRunStats.setupMs = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - startTime).count();
+			if (frameCount == warmupFrames)
+			{	// Only measure from here
+				fpsTimer.ResetHistory();
+				system.GetGpuProfiler().ResetRegionTimes();
+			}
+			if (frameLimit > 0 && frameCount >= warmupFrames + frameLimit)
+			{
+				if (!headless)
+					window.ExitApplication();
+				else if (!captureFile.empty())
+					swapChain.CaptureLastFrame(system, frameCapture);
+				break;
+			}
+		}
+
+		lastRunStats.frameStats = fpsTimer.GetStats();
+		lastRunStats.gpuRegionTimes = system.GetGpuProfiler().GetRegionTimes();
+		lastRunStats.deviceMemory = system.GetDeviceMemory();
+		lastRunStats.peakDeviceMemory = system.GetPeakDeviceMemory();
+		lastRunStats.apiCalls = ApiCounters::GetLastFrame();
+
+		if (frameCapture.Pending())
+		{
+			if (!frameCapture.SavePng(system, captureFile))
+				WinUtils::OutputError("Failed to write " + captureFile);
+			if (!goldenFile.empty() && std::ifstream(goldenFile).good())
+			{
+				lastRunStats.golden = frameCapture.Compare(system, goldenFile, captureTolerance);
+				lastRunStats.goldenCompared = true;
+			}
+		}
+
+		if (!app.GetFrameStatsFile().empty())
+		{
+			fpsTimer.WriteCsv(app.GetFrameStatsFile() + ".csv");
+			fpsTimer.WriteJson(app.GetFrameStatsFile() + ".json");
 		}
 	}
 	catch (std::runtime_error & err)
 	{
 		WinUtils::OutputError("Application terminated, fatal error: " + std::string(err.what()));
 		window.ExitApplication();
+		succeeded = false;
 	}
+	finished = true;
 	system.DeviceWaitIdle();
 
 	app.Tidy(system);
 
+	frameCapture.Tidy(system);
 	swapChain.Tidy(system);
 	renderPasses.Tidy(system);
+	return succeeded;
 }
 
 void WindowSystem::Close()
@@ -116,12 +213,16 @@ void WindowSystem::Close()
 	{
 		system.TidyUp();
 
-		GLFW::DestroySurface(instance, windowSurface);
+		if (windowSurface != nullptr)
+			GLFW::DestroySurface(instance, windowSurface);
 		extensions.TidyUpDebugCallback();
 		vkDestroyInstance(instance, nullptr);
 
-		window.Tidy();
-		GLFW::Terminate();
+		if (!headless)
+		{
+			window.Tidy();
+			GLFW::Terminate();
+		}
 	}
 	catch (std::runtime_error & err)
 	{
@@ -129,7 +230,8 @@ void WindowSystem::Close()
 	}
 
 #ifndef _DEBUG
-	WinUtils::Pause();	// Prompt for pause
+	if (!headless)
+		WinUtils::Pause();	// Prompt for pause
 #endif
 }
 
@@ -147,3 +249,16 @@ void WindowSystem::RunWindowed(int width, int height, const std::string& name, V
 
 	windowSystem.Close();
 }
+
+bool WindowSystem::RunHeadless(int width, int height, const std::string& name, VulkanApplication& app, uint32_t numFrames)
+{
+	WindowSystem windowSystem;
+	if (!windowSystem.InitHeadless(width, height, name))
+		return false;
+
+	app.SetTitle(name);
+	windowSystem.SetFrameLimit(numFrames);
+	bool succeeded = windowSystem.RunApp(app);
+	windowSystem.Close();
+	return succeeded;
+}
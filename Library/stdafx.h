@@ -10,6 +10,7 @@
 #pragma warning(disable:26812)  //enum class warning
 
 #include <vulkan/vulkan.h>
+#include "VulkanPlayground\ApiCounters.h"	// Redirects some Vulkan calls so they're counted
 
 #include <string>
 #include <sstream>
@@ -22,6 +23,7 @@
 #include <algorithm>
 #include <functional>
 #include <array>
+#include <cassert>
 #include <chrono>
 #include <fstream>
 